@@ -0,0 +1,164 @@
+/*
+  Benchmark of the A2DP Sink PCM pipeline
+
+  Copyright (C) 2020 Phil Schatzmann
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ==> We push synthetic stereo PCM packets with the real A2DP sizes through
+// audio_data_callback() and report the time that is spent in each stage
+// (channel swap, raw_stream_reader, volume, stream_reader, write_audio) in
+// ns/frame and cycles/frame and the number of heap blocks that were allocated.
+// Bluetooth is not started, so the numbers are reproducible.
+// The same stages can be measured on the host with tests/host/benchmark_pipeline.cpp
+
+#include "AudioTools.h"
+#include "BluetoothA2DPSink.h"
+#include "esp_heap_caps.h"
+
+enum Stage { Swap, RawReader, Volume, Reader, Write, StageCount };
+const char* stage_names[] = {"swap", "raw_stream_reader", "volume",
+                             "stream_reader", "write_audio"};
+const int sizes[] = {512, 4096};
+const int rates[] = {44100, 48000};
+const int iterations = 1000;
+
+// time stamps (in cycles) which are recorded while the callback is executed
+uint32_t t_start, t_raw_in, t_raw_out, t_reader_in, t_reader_out, t_write_in,
+    t_write_out;
+uint64_t cycles[StageCount];
+int heap_blocks[StageCount];
+bool record_heap = false;
+size_t blocks_start, blocks_raw_in, blocks_raw_out, blocks_reader_in,
+    blocks_reader_out, blocks_write_in, blocks_write_out;
+
+size_t allocated_blocks() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  return info.allocated_blocks;
+}
+
+/// Output which just consumes the data
+class NullOutput : public BluetoothA2DPOutput {
+ public:
+  bool begin() override { return true; }
+  size_t write(const uint8_t* data, size_t len) override { return len; }
+  void end() override {}
+  void set_sample_rate(int rate) override {}
+  void set_output_active(bool active) override {}
+};
+
+/// Sink which gives us access to the protected data callback
+class BenchmarkSink : public BluetoothA2DPSink {
+ public:
+  BenchmarkSink(BluetoothA2DPOutput& out) : BluetoothA2DPSink(out) {}
+  void process(uint8_t* data, uint32_t len) { audio_data_callback(data, len); }
+
+ protected:
+  size_t write_audio(const uint8_t* data, size_t size) override {
+    if (record_heap) blocks_write_in = allocated_blocks();
+    t_write_in = ESP.getCycleCount();
+    size_t result = BluetoothA2DPSink::write_audio(data, size);
+    t_write_out = ESP.getCycleCount();
+    if (record_heap) blocks_write_out = allocated_blocks();
+    return result;
+  }
+};
+
+NullOutput null_out;
+BenchmarkSink a2dp_sink(null_out);
+uint8_t pcm_ref[4096];
+uint8_t pcm[4096];
+
+void raw_reader(const uint8_t* data, uint32_t len) {
+  t_raw_in = ESP.getCycleCount();
+  if (record_heap) blocks_raw_in = blocks_raw_out = allocated_blocks();
+  t_raw_out = ESP.getCycleCount();
+}
+
+void reader(const uint8_t* data, uint32_t len) {
+  t_reader_in = ESP.getCycleCount();
+  if (record_heap) blocks_reader_in = blocks_reader_out = allocated_blocks();
+  t_reader_out = ESP.getCycleCount();
+}
+
+void measure(int size) {
+  memset(cycles, 0, sizeof(cycles));
+  for (int j = 0; j < iterations; j++) {
+    memcpy(pcm, pcm_ref, size);
+    t_start = ESP.getCycleCount();
+    a2dp_sink.process(pcm, size);
+    cycles[Swap] += t_raw_in - t_start;
+    cycles[RawReader] += t_raw_out - t_raw_in;
+    cycles[Volume] += t_reader_in - t_raw_out;
+    cycles[Reader] += t_reader_out - t_reader_in;
+    cycles[Write] += t_write_out - t_write_in;
+  }
+
+  // separate run to determine the allocations
+  memcpy(pcm, pcm_ref, size);
+  record_heap = true;
+  blocks_start = allocated_blocks();
+  a2dp_sink.process(pcm, size);
+  record_heap = false;
+  heap_blocks[Swap] = blocks_raw_in - blocks_start;
+  heap_blocks[RawReader] = blocks_raw_out - blocks_raw_in;
+  heap_blocks[Volume] = blocks_reader_in - blocks_raw_out;
+  heap_blocks[Reader] = blocks_reader_out - blocks_reader_in;
+  heap_blocks[Write] = blocks_write_out - blocks_write_in;
+}
+
+void report(int size, int rate) {
+  int frames = size / 4;
+  float mhz = getCpuFrequencyMhz();
+  float budget_ns = 1000000000.0f * frames / rate;
+  float total_ns = 0;
+  Serial.printf("--- %d bytes (%d frames) @ %d Hz\n", size, frames, rate);
+  for (int s = 0; s < StageCount; s++) {
+    float cycles_per_frame = (float)cycles[s] / iterations / frames;
+    float ns_per_frame = cycles_per_frame * 1000.0f / mhz;
+    total_ns += ns_per_frame * frames;
+    Serial.printf("%-18s %8.2f ns/frame %8.2f cycles/frame %3d allocs\n",
+                  stage_names[s], ns_per_frame, cycles_per_frame,
+                  heap_blocks[s]);
+  }
+  Serial.printf("total %.1f us per packet = %.2f%% of the real time budget\n",
+                total_ns / 1000.0f, total_ns * 100.0f / budget_ns);
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  // synthetic decoded SBC output: 1 kHz sine on both channels
+  int16_t* samples = (int16_t*)pcm_ref;
+  for (int j = 0; j < sizeof(pcm_ref) / 4; j++) {
+    int16_t value = 16000 * sin(2.0 * PI * 1000.0 * j / 44100.0);
+    samples[j * 2] = value;
+    samples[j * 2 + 1] = -value;
+  }
+
+  // activate all stages
+  a2dp_sink.set_swap_lr_channels(true);
+  a2dp_sink.set_raw_stream_reader(raw_reader);
+  a2dp_sink.set_stream_reader(reader, true);
+  a2dp_sink.set_volume(100);
+  a2dp_sink.set_output_active(true);
+
+  for (int size : sizes) {
+    measure(size);
+    for (int rate : rates) {
+      report(size, rate);
+    }
+  }
+}
+
+void loop() { delay(1000); }
@@ -0,0 +1,71 @@
+/*
+  Benchmark of the A2DP Source sample rate converter
+
+  Copyright (C) 2020 Phil Schatzmann
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ==> We convert a synthetic stereo sine from different input rates to 44100
+// with each A2DPResamplerQuality and report the cycles per output frame and
+// the resulting load in MIPS (million cycles per second of audio) and in
+// percent of the CPU. Bluetooth is not started, so the numbers are
+// reproducible.
+
+#include "BluetoothA2DPSource.h"
+
+const int rates[] = {16000, 22050, 48000};
+const char* quality_names[] = {"linear", "low", "medium", "high"};
+const int frames_per_block = 128;  // 512 bytes: typical request of the encoder
+const int blocks = 500;
+
+A2DPPolyphaseResampler resampler;
+Frame output[frames_per_block];
+
+void measure(int rate, A2DPResamplerQuality quality) {
+  resampler.begin(rate, 44100, quality);
+  uint32_t cycles = 0;
+  uint32_t phase = 0;
+  uint32_t phase_inc = (uint32_t)(4294967296.0 * 1000.0 / rate);
+  for (int j = 0; j < blocks; j++) {
+    // provide the input: this is not measured
+    size_t needed = resampler.input_frames(frames_per_block);
+    Frame* input = resampler.input_area(needed);
+    for (size_t i = 0; i < needed; i++) {
+      int16_t value = 16000 * sin(2.0 * PI * phase / 4294967296.0);
+      input[i] = Frame(value, -value);
+      phase += phase_inc;
+    }
+    resampler.commit_input(needed);
+
+    uint32_t start = ESP.getCycleCount();
+    resampler.read(output, frames_per_block);
+    cycles += ESP.getCycleCount() - start;
+  }
+
+  float cycles_per_frame = (float)cycles / blocks / frames_per_block;
+  float mips = cycles_per_frame * 44100 / 1000000.0f;
+  Serial.printf("%5d Hz %-7s %2d taps %8.1f cycles/frame %6.2f MIPS %5.1f%% CPU\n",
+                rate, quality_names[quality], resampler.filter_taps(),
+                cycles_per_frame, mips, mips * 100.0f / getCpuFrequencyMhz());
+}
+
+void setup() {
+  Serial.begin(115200);
+  for (int rate : rates) {
+    for (int q = A2DP_RESAMPLE_LINEAR; q <= A2DP_RESAMPLE_HIGH; q++) {
+      measure(rate, (A2DPResamplerQuality)q);
+    }
+  }
+  resampler.end();
+}
+
+void loop() { delay(1000); }
@@ -0,0 +1,126 @@
+#pragma once
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Copyright 2020 Phil Schatzmann
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+/**
+ * @brief Fixed size memory pool for the parameters of the messages which are
+ * sent to the app task. The slots are allocated once and managed with an
+ * atomic bitmap, so alloc() and free() can be called from different tasks
+ * w/o locking. If a request is too big or all slots are in use we fall back
+ * to the heap and count this as miss.
+ * @author Phil Schatzmann
+ * @copyright Apache License Version 2
+ */
+class A2DPMessagePool {
+ public:
+  A2DPMessagePool() = default;
+  A2DPMessagePool(const A2DPMessagePool&) = delete;
+  A2DPMessagePool& operator=(const A2DPMessagePool&) = delete;
+  ~A2DPMessagePool() { end(); }
+
+  /// Allocates the slots: must not be called while the pool is in use
+  bool begin(int slotCount, size_t slotSize) {
+    end();
+    if (slotCount <= 0 || slotSize == 0) return false;
+    // keep the slots aligned
+    slot_size = (slotSize + 7) & ~(size_t)7;
+    word_count = (slotCount + 31) / 32;
+    memory = (uint8_t*)malloc(slot_size * slotCount);
+    bitmap = new (std::nothrow) std::atomic<uint32_t>[word_count];
+    if (memory == nullptr || bitmap == nullptr) {
+      end();
+      return false;
+    }
+    slot_count = slotCount;
+    for (int j = 0; j < word_count; j++) {
+      // mark the bits which do not have a slot as used
+      int bits = slot_count - j * 32;
+      bitmap[j] = bits >= 32 ? 0 : ~((1u << bits) - 1);
+    }
+    return true;
+  }
+
+  /// Releases the slots: must not be called while the pool is in use
+  void end() {
+    if (memory != nullptr) {
+      ::free(memory);
+      memory = nullptr;
+    }
+    if (bitmap != nullptr) {
+      delete[] bitmap;
+      bitmap = nullptr;
+    }
+    slot_count = 0;
+    word_count = 0;
+  }
+
+  /// Returns true if the slots have been allocated
+  operator bool() { return memory != nullptr; }
+
+  /// Provides memory for len bytes: from the pool or from the heap
+  void* alloc(size_t len) {
+    if (len <= slot_size) {
+      for (int j = 0; j < word_count; j++) {
+        uint32_t bits = bitmap[j].load(std::memory_order_relaxed);
+        while (bits != 0xFFFFFFFF) {
+          int bit = __builtin_ctz(~bits);
+          if (bitmap[j].compare_exchange_weak(bits, bits | (1u << bit),
+                                              std::memory_order_acquire)) {
+            return memory + (j * 32 + bit) * slot_size;
+          }
+        }
+      }
+    }
+    misses++;
+    return malloc(len);
+  }
+
+  /// Releases memory which was provided by alloc()
+  void free(void* ptr) {
+    if (ptr == nullptr) return;
+    uint8_t* p = (uint8_t*)ptr;
+    if (memory != nullptr && p >= memory &&
+        p < memory + slot_count * slot_size) {
+      int slot = (p - memory) / slot_size;
+      bitmap[slot / 32].fetch_and(~(1u << (slot % 32)),
+                                  std::memory_order_release);
+    } else {
+      ::free(ptr);
+    }
+  }
+
+  /// Number of allocations which needed to use the heap
+  uint32_t pool_misses() { return misses; }
+
+  /// Number of slots
+  int size() { return slot_count; }
+
+  /// Size of a slot in bytes
+  size_t slot_bytes() { return slot_size; }
+
+ protected:
+  uint8_t* memory = nullptr;
+  std::atomic<uint32_t>* bitmap = nullptr;
+  size_t slot_size = 0;
+  int slot_count = 0;
+  int word_count = 0;
+  std::atomic<uint32_t> misses{0};
+};
@@ -0,0 +1,316 @@
+#pragma once
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Copyright 2020 Phil Schatzmann
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "A2DPVolumeControl.h"
+
+/**
+ * @brief Fractional resampler for stereo 16 bit frames which uses linear
+ * interpolation. It is intended for small corrections (e.g. of the clock
+ * drift between the A2DP source and the I2S output), so the step can be
+ * defined with a resolution of 2^-32.
+ *
+ * The last input frame is kept, so that the blocks can be processed one after
+ * the other w/o any discontinuity.
+ * @author Phil Schatzmann
+ * @copyright Apache License Version 2
+ */
+class A2DPLinearResampler {
+ public:
+  A2DPLinearResampler() = default;
+
+  /// Defines the number of input frames per output frame: > 1.0 reduces the
+  /// number of frames, < 1.0 increases it
+  void set_factor(float factor) {
+    if (factor <= 0.0f) return;
+    step = (uint64_t)((double)factor * 4294967296.0);
+  }
+
+  /// Provides the number of input frames per output frame
+  float factor() { return (double)step / 4294967296.0; }
+
+  /// Forgets the history
+  void reset() {
+    last = Frame();
+    pos = 0;
+  }
+
+  /// Maximum number of output frames for the indicated input frames
+  size_t max_output_frames(size_t inFrames) {
+    return ((uint64_t)inFrames << 32) / step + 1;
+  }
+
+  /// Resamples the frames and passes each result to write(const Frame&):
+  /// returns the number of output frames
+  template <typename Writer>
+  size_t resample(const Frame* in, size_t inFrames, Writer write) {
+    if (in == nullptr || inFrames == 0) return 0;
+    size_t result = 0;
+    uint64_t end = (uint64_t)inFrames << 32;
+    // pos is relative to the last frame of the previous block
+    while (pos < end) {
+      size_t idx = pos >> 32;
+      // 15 bits, so that the interpolation can not overflow
+      int32_t frac = (pos >> 17) & 0x7FFF;
+      const Frame& a = idx == 0 ? last : in[idx - 1];
+      const Frame& b = in[idx];
+      Frame frame(a.channel1 + (((b.channel1 - a.channel1) * frac) >> 15),
+                  a.channel2 + (((b.channel2 - a.channel2) * frac) >> 15));
+      write(frame);
+      result++;
+      pos += step;
+    }
+    pos -= end;
+    last = in[inFrames - 1];
+    return result;
+  }
+
+ protected:
+  uint64_t step = 1ull << 32;
+  uint64_t pos = 0;
+  Frame last;
+};
+
+/**
+ * @brief Quality levels of the A2DPPolyphaseResampler: the number of filter
+ * taps determines the CPU load.
+ * @ingroup a2dp
+ */
+enum A2DPResamplerQuality {
+  A2DP_RESAMPLE_LINEAR,  ///< 2 taps: linear interpolation
+  A2DP_RESAMPLE_LOW,     ///< 8 taps
+  A2DP_RESAMPLE_MEDIUM,  ///< 16 taps
+  A2DP_RESAMPLE_HIGH,    ///< 32 taps
+};
+
+/**
+ * @brief Streaming sample rate converter for stereo 16 bit frames with a
+ * fixed point polyphase filter (windowed sinc with Q14 coefficients). The
+ * filter is band limited to the lower of the two rates, so it can be used to
+ * convert between any rates (e.g. 16000, 22050 or 48000 to 44100).
+ *
+ * The result is interpolated between the two nearest filter phases. Measured
+ * SNR of a sine for 48000 -> 44100 (at 1 kHz / 10 kHz): linear 56 / 16 dB,
+ * low 80 / 31 dB, medium 83 / 79 dB, high 81 / 78 dB. Above medium the 16 bit
+ * output limits the SNR, while high has the steeper transition band.
+ *
+ * The input is written into an internal buffer (directly with input_area()
+ * and commit_input() or with write()) and the output is provided by read().
+ * input_frames() tells how many input frames are needed for the requested
+ * number of output frames.
+ * @author Phil Schatzmann
+ * @copyright Apache License Version 2
+ */
+class A2DPPolyphaseResampler {
+ public:
+  A2DPPolyphaseResampler() = default;
+  A2DPPolyphaseResampler(const A2DPPolyphaseResampler&) = delete;
+  A2DPPolyphaseResampler& operator=(const A2DPPolyphaseResampler&) = delete;
+  ~A2DPPolyphaseResampler() { end(); }
+
+  /// Calculates the filter for the indicated rates: must not be called while
+  /// the resampler is in use
+  bool begin(int inRate, int outRate,
+             A2DPResamplerQuality quality = A2DP_RESAMPLE_MEDIUM) {
+    end();
+    if (inRate <= 0 || outRate <= 0) return false;
+    static const int quality_taps[] = {2, 8, 16, 32};
+    static const int quality_phase_bits[] = {8, 5, 6, 7};
+    taps = quality_taps[quality];
+    phase_bits = quality_phase_bits[quality];
+    step = ((uint64_t)inRate << 32) / outRate;
+    int phases = 1 << phase_bits;
+    // one additional set, so that we can interpolate after the last phase
+    coefficients = (int16_t*)malloc(sizeof(int16_t) * taps * (phases + 1));
+    if (coefficients == nullptr) {
+      end();
+      return false;
+    }
+    // when we reduce the rate the filter must remove the frequencies above
+    // the new nyquist frequency
+    float cutoff = inRate > outRate ? (float)outRate / inRate : 1.0f;
+    if (quality != A2DP_RESAMPLE_LINEAR) cutoff *= 0.92f;
+    for (int p = 0; p <= phases; p++) {
+      calculate_phase(coefficients + p * taps, (float)p / phases, cutoff,
+                      quality == A2DP_RESAMPLE_LINEAR);
+    }
+    reset();
+    return true;
+  }
+
+  /// Releases the memory
+  void end() {
+    if (coefficients != nullptr) {
+      free(coefficients);
+      coefficients = nullptr;
+    }
+    if (buffer != nullptr) {
+      free(buffer);
+      buffer = nullptr;
+    }
+    buffer_capacity = 0;
+    buffer_count = 0;
+    taps = 0;
+  }
+
+  /// Returns true if the filter has been calculated
+  operator bool() { return coefficients != nullptr; }
+
+  /// Forgets the history: we start with silence
+  void reset() {
+    pos = 0;
+    buffer_count = 0;
+    if (taps > 0 && reserve(taps - 1)) {
+      memset((void*)buffer, 0, sizeof(Frame) * (taps - 1));
+      buffer_count = taps - 1;
+    }
+  }
+
+  /// Number of filter taps
+  int filter_taps() { return taps; }
+
+  /// Number of input frames which need to be added to produce the indicated
+  /// number of output frames
+  size_t input_frames(size_t outFrames) {
+    if (outFrames == 0 || taps == 0) return 0;
+    size_t needed = ((pos + step * (outFrames - 1)) >> 32) + taps;
+    return needed > buffer_count ? needed - buffer_count : 0;
+  }
+
+  /// Provides the memory at the end of the input buffer for the indicated
+  /// number of frames
+  Frame* input_area(size_t frames) {
+    if (!reserve(buffer_count + frames)) return nullptr;
+    return buffer + buffer_count;
+  }
+
+  /// Adds the frames which were written into the input_area()
+  void commit_input(size_t frames) { buffer_count += frames; }
+
+  /// Copies the frames into the input buffer
+  size_t write(const Frame* in, size_t frames) {
+    Frame* area = input_area(frames);
+    if (area == nullptr) return 0;
+    memcpy((void*)area, in, frames * sizeof(Frame));
+    commit_input(frames);
+    return frames;
+  }
+
+  /// Provides up to maxFrames resampled frames: returns the number of frames
+  size_t read(Frame* out, size_t maxFrames) {
+    if (coefficients == nullptr) return 0;
+    size_t result = 0;
+    int shift = 32 - phase_bits;
+    while (result < maxFrames) {
+      size_t idx = pos >> 32;
+      if (idx + taps > buffer_count) break;
+      // the result is interpolated between the 2 nearest phases, so that the
+      // gain stays exact
+      uint32_t frac = (uint32_t)pos;
+      int32_t mix = (frac >> (shift - 15)) & 0x7FFF;
+      const int16_t* coef = coefficients + (frac >> shift) * taps;
+      const int16_t* next = coef + taps;
+      const Frame* frame = buffer + idx;
+      int32_t left = 0;
+      int32_t right = 0;
+      int32_t left_next = 0;
+      int32_t right_next = 0;
+      for (int k = 0; k < taps; k++) {
+        left += frame[k].channel1 * coef[k];
+        right += frame[k].channel2 * coef[k];
+        left_next += frame[k].channel1 * next[k];
+        right_next += frame[k].channel2 * next[k];
+      }
+      left += ((int64_t)(left_next - left) * mix) >> 15;
+      right += ((int64_t)(right_next - right) * mix) >> 15;
+      left = (left + 0x2000) >> 14;
+      right = (right + 0x2000) >> 14;
+      out[result].channel1 = left < -32768 ? -32768 : (left > 32767 ? 32767 : left);
+      out[result].channel2 = right < -32768 ? -32768 : (right > 32767 ? 32767 : right);
+      result++;
+      pos += step;
+    }
+    // remove the input which is not needed any more
+    size_t used = pos >> 32;
+    if (used > buffer_count) used = buffer_count;
+    if (used > 0) {
+      memmove((void*)buffer, buffer + used, (buffer_count - used) * sizeof(Frame));
+      buffer_count -= used;
+      pos -= (uint64_t)used << 32;
+    }
+    return result;
+  }
+
+ protected:
+  int16_t* coefficients = nullptr;
+  int taps = 0;
+  int phase_bits = 0;
+  uint64_t step = 1ull << 32;
+  // position of the next output frame relative to the first buffered frame
+  uint64_t pos = 0;
+  Frame* buffer = nullptr;
+  size_t buffer_capacity = 0;
+  size_t buffer_count = 0;
+
+  bool reserve(size_t frames) {
+    if (frames <= buffer_capacity) return true;
+    Frame* tmp = (Frame*)realloc((void*)buffer, frames * sizeof(Frame));
+    if (tmp == nullptr) return false;
+    buffer = tmp;
+    buffer_capacity = frames;
+    return true;
+  }
+
+  /// Calculates the normalized Q14 coefficients for the fractional position
+  void calculate_phase(int16_t* coef, float frac, float cutoff, bool isLinear) {
+    float values[32];
+    float sum = 0.0f;
+    float center = taps / 2 - 1 + frac;
+    for (int k = 0; k < taps; k++) {
+      float x = k - center;
+      float value;
+      if (isLinear) {
+        value = 1.0f - fabsf(x);
+        if (value < 0.0f) value = 0.0f;
+      } else {
+        // sinc with blackman window
+        float arg = (float)M_PI * x * cutoff;
+        float sinc = fabsf(arg) < 1e-6f ? 1.0f : sinf(arg) / arg;
+        float w = (float)M_PI * x / (taps / 2);
+        float window = 0.42f + 0.5f * cosf(w) + 0.08f * cosf(2.0f * w);
+        if (fabsf(x) >= taps / 2) window = 0.0f;
+        value = sinc * window;
+      }
+      values[k] = value;
+      sum += value;
+    }
+    // unity gain for each phase: the rounding error is added to the biggest
+    // coefficient
+    int total = 0;
+    int max_k = 0;
+    for (int k = 0; k < taps; k++) {
+      coef[k] = lrintf(values[k] * 16384.0f / sum);
+      total += coef[k];
+      if (coef[k] > coef[max_k]) max_k = k;
+    }
+    coef[max_k] += 16384 - total;
+  }
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Copyright 2020 Phil Schatzmann
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+
+/**
+ * @brief Up to 2 continuous memory areas of a ring buffer: the second area is
+ * only used when the data wraps around the end of the buffer.
+ * @author Phil Schatzmann
+ * @copyright Apache License Version 2
+ */
+struct A2DPRingBufferView {
+  uint8_t* data[2] = {nullptr, nullptr};
+  size_t len[2] = {0, 0};
+  /// Total number of bytes in both areas
+  size_t total() { return len[0] + len[1]; }
+};
+
+/**
+ * @brief Lock free byte ring buffer for exactly one producer and one consumer
+ * (e.g. the BT data callback and the I2S task). The producer only updates the
+ * write position and the consumer only updates the read position, so no
+ * locking is needed.
+ *
+ * The data can be copied with write() and read(), or accessed in place with
+ * write_view() / commit() and read_view() / consume().
+ * @author Phil Schatzmann
+ * @copyright Apache License Version 2
+ */
+class A2DPRingBuffer {
+ public:
+  A2DPRingBuffer() = default;
+  A2DPRingBuffer(const A2DPRingBuffer&) = delete;
+  A2DPRingBuffer& operator=(const A2DPRingBuffer&) = delete;
+  ~A2DPRingBuffer() { end(); }
+
+  /// (Re)allocates the buffer: must not be called while it is in use
+  bool resize(size_t size) {
+    end();
+    if (size == 0) return false;
+    buffer = (uint8_t*)malloc(size);
+    if (buffer == nullptr) return false;
+    buffer_size = size;
+    reset();
+    return true;
+  }
+
+  /// Releases the memory
+  void end() {
+    if (buffer != nullptr) {
+      free(buffer);
+      buffer = nullptr;
+    }
+    buffer_size = 0;
+    reset();
+  }
+
+  /// Clears the data: must not be called while it is in use
+  void reset() {
+    write_pos.store(0, std::memory_order_relaxed);
+    read_pos.store(0, std::memory_order_release);
+  }
+
+  /// Returns true if the buffer has been allocated
+  operator bool() { return buffer != nullptr; }
+
+  /// Capacity in bytes
+  size_t size() { return buffer_size; }
+
+  /// Number of bytes that can be read
+  size_t available() {
+    return used(write_pos.load(std::memory_order_acquire),
+                read_pos.load(std::memory_order_relaxed));
+  }
+
+  /// Number of bytes that can be written
+  size_t available_for_write() {
+    return buffer_size - used(write_pos.load(std::memory_order_relaxed),
+                              read_pos.load(std::memory_order_acquire));
+  }
+
+  /// Fill level in percent
+  int level_percent() {
+    return buffer_size == 0 ? 0 : available() * 100 / buffer_size;
+  }
+
+  /// Producer: copies up to len bytes into the buffer
+  size_t write(const uint8_t* data, size_t len) {
+    A2DPRingBufferView view = write_view();
+    size_t result = copy(view, (uint8_t*)data, len, true);
+    commit(result);
+    return result;
+  }
+
+  /// Consumer: copies up to len bytes from the buffer
+  size_t read(uint8_t* data, size_t len) {
+    A2DPRingBufferView view = read_view();
+    size_t result = copy(view, data, len, false);
+    consume(result);
+    return result;
+  }
+
+  /// Producer: provides the free memory which can be written to
+  A2DPRingBufferView write_view() {
+    size_t pos = write_pos.load(std::memory_order_relaxed);
+    size_t len =
+        buffer_size - used(pos, read_pos.load(std::memory_order_acquire));
+    return view(pos, len);
+  }
+
+  /// Producer: makes len bytes which were written into the write_view()
+  /// available to the consumer
+  void commit(size_t len) {
+    size_t pos = write_pos.load(std::memory_order_relaxed);
+    write_pos.store(advance(pos, len), std::memory_order_release);
+  }
+
+  /// Consumer: provides the data which can be read
+  A2DPRingBufferView read_view() {
+    size_t pos = read_pos.load(std::memory_order_relaxed);
+    size_t len = used(write_pos.load(std::memory_order_acquire), pos);
+    return view(pos, len);
+  }
+
+  /// Consumer: releases len bytes of the read_view()
+  void consume(size_t len) {
+    size_t pos = read_pos.load(std::memory_order_relaxed);
+    read_pos.store(advance(pos, len), std::memory_order_release);
+  }
+
+ protected:
+  uint8_t* buffer = nullptr;
+  size_t buffer_size = 0;
+  // positions are in the range of 0 to 2 * buffer_size, so that a full buffer
+  // can be distinguished from an empty one
+  std::atomic<size_t> write_pos{0};
+  std::atomic<size_t> read_pos{0};
+
+  size_t used(size_t write, size_t read) {
+    return write >= read ? write - read : 2 * buffer_size - read + write;
+  }
+
+  size_t advance(size_t pos, size_t len) {
+    pos += len;
+    return pos >= 2 * buffer_size ? pos - 2 * buffer_size : pos;
+  }
+
+  A2DPRingBufferView view(size_t pos, size_t len) {
+    A2DPRingBufferView result;
+    if (len == 0) return result;
+    size_t idx = pos >= buffer_size ? pos - buffer_size : pos;
+    size_t first = buffer_size - idx;
+    result.data[0] = buffer + idx;
+    result.len[0] = len < first ? len : first;
+    if (len > first) {
+      result.data[1] = buffer;
+      result.len[1] = len - first;
+    }
+    return result;
+  }
+
+  size_t copy(A2DPRingBufferView& view, uint8_t* data, size_t len,
+              bool toBuffer) {
+    size_t result = 0;
+    for (int j = 0; j < 2 && result < len; j++) {
+      size_t n = len - result;
+      if (n > view.len[j]) n = view.len[j];
+      if (n == 0) continue;
+      if (toBuffer)
+        memcpy(view.data[j], data + result, n);
+      else
+        memcpy(data + result, view.data[j], n);
+      result += n;
+    }
+    return result;
+  }
+};
@@ -15,7 +15,20 @@
 // Copyright 2020 Phil Schatzmann
 // Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
 
-#include "esp_log.h"
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+
+// The volume control is pure PCM processing: it only needs the logger, so it
+// can also be compiled outside of the ESP-IDF (e.g. for tests on the host)
+#if __has_include("esp_log.h")
+#  include "esp_log.h"
+#else
+#  define ESP_LOGD(tag, ...)
+#endif
 
     /**
      * @brief Utility structure that can be used to split a int32_t up into 2
@@ -73,26 +86,79 @@ class A2DPVolumeControl {
    * @param frameCount Number of frames to process
    */
   virtual void update_audio_data(Frame* data, uint16_t frameCount) {
-    if (data != nullptr && frameCount > 0 && (mono_downmix || is_volume_used)) {
-      ESP_LOGD("VolumeControl", "update_audio_data");
-      for (int i = 0; i < frameCount; i++) {
-        int32_t pcmLeft = data[i].channel1;
-        int32_t pcmRight = data[i].channel2;
-        // if mono -> we provide the same output on both channels
-        if (mono_downmix) {
-          pcmRight = pcmLeft = (pcmLeft + pcmRight) / 2;
-        }
-        // adjust the volume
-        if (is_volume_used) {
-          pcmLeft = clip(pcmLeft * volumeFactor / volumeFactorMax);
-          pcmRight = clip(pcmRight * volumeFactor / volumeFactorMax);
-        }
-        data[i].channel1 = pcmLeft;
-        data[i].channel2 = pcmRight;
-      }
+    update_audio_data(data, data, frameCount, false);
+  }
+
+  /**
+   * @brief Swaps the channels, applies the mono downmix and the volume in one
+   * pass over the data. This is only used instead of update_audio_data(Frame*,
+   * uint16_t) if supports_fused() returns true.
+   * @param src Pointer to the input frames
+   * @param dst Pointer to the output frames: can be identical with src
+   * @param frameCount Number of frames to process
+   * @param swap True to swap the left and right channel
+   */
+  virtual void update_audio_data(const Frame* src, Frame* dst,
+                                 uint16_t frameCount, bool swap) {
+    if (src == nullptr || dst == nullptr || frameCount == 0) return;
+    ESP_LOGD("VolumeControl", "update_audio_data");
+    // the gain is changing: the frames of the ramp are processed first
+    if (update_ramp()) {
+      uint16_t done = apply_ramp(src, dst, frameCount, swap);
+      src += done;
+      dst += done;
+      frameCount -= done;
+      if (frameCount == 0) return;
+    }
+    if (ramp_factor == 0) {
+      memset((void*)dst, 0, frameCount * sizeof(Frame));
+      return;
+    }
+    // select the loop once per block, so that the inner loops are branch free
+    if (swap) {
+      if (mono_downmix)
+        transform<true, true>(src, dst, frameCount);
+      else
+        transform<true, false>(src, dst, frameCount);
+    } else if (mono_downmix) {
+      transform<false, true>(src, dst, frameCount);
+    } else if (is_volume_used) {
+      int shift = volume_factor_shift();
+      if (shift >= 0)
+        scale_samples<true>(src, dst, frameCount * 2, shift);
+      else
+        scale_samples<false>(src, dst, frameCount * 2, shift);
+    } else if (src != dst) {
+      memmove(dst, src, frameCount * sizeof(Frame));
     }
   }
 
+  /**
+   * @brief Checks if the fused update_audio_data(const Frame*, Frame*,
+   * uint16_t, bool) implements the same processing as update_audio_data(Frame*,
+   * uint16_t), so that the callers can swap the channels and write to a
+   * different destination in the same pass. The provided controls opt in:
+   * their subclasses which override update_audio_data(Frame*, uint16_t) must
+   * return false again.
+   * @return False, so that the overridden update_audio_data(Frame*, uint16_t)
+   * of subclasses is never skipped
+   */
+  virtual bool supports_fused() { return false; }
+
+  /**
+   * @brief Checks if update_audio_data() would leave the data unchanged, so
+   * that the call can be skipped. Gains within 1/4096 of unity are treated as
+   * unity (the default volume curves end at 4095/4096).
+   * @return True if the control supports_fused() and there is no mono
+   * downmix, no active ramp and the gain is unity
+   */
+  virtual bool is_unity() {
+    if (!supports_fused() || mono_downmix || !is_ramp_active) return false;
+    int32_t factor = target_factor();
+    if (factor != ramp_factor || ramp_gain != ramp_target) return false;
+    return (int64_t)factor * 4096 >= (int64_t)volumeFactorMax * 4095;
+  }
+
   /**
    * @brief Gets the current volume factor
    * @return Volume factor in the range of 0 to 4096
@@ -123,23 +189,200 @@ class A2DPVolumeControl {
    */
   virtual void set_volume(uint8_t volume) = 0;
 
+  /**
+   * @brief Defines the length of the gain ramps which are used when the
+   * volume changes or when we fade in or out
+   * @param frames Number of frames: 0 changes the gain w/o ramp
+   */
+  void set_ramp_frames(uint16_t frames) { ramp_frames = frames; }
+
+  /**
+   * @brief Ramps the gain up from the actual value to the volume
+   */
+  void fade_in() { is_fade_out = false; }
+
+  /**
+   * @brief Ramps the gain down to 0: the output stays silent until fade_in()
+   * is called
+   * @param immediate True to set the gain to 0 w/o ramp
+   */
+  void fade_out(bool immediate = false) {
+    if (immediate) is_fade_reset = true;
+    is_fade_out = true;
+  }
+
+  /**
+   * @brief Checks if the output has been faded out
+   */
+  bool is_faded_out() { return is_fade_out; }
+
  protected:
   bool is_volume_used = false;  ///< Flag indicating if volume control is enabled
   bool mono_downmix = false;    ///< Flag indicating if mono downmix is enabled
   int32_t volumeFactor = 1;     ///< Current volume factor
   int32_t volumeFactorMax = 0x1000;     ///< Maximum volume factor (4096)
   int32_t volumeFactorClippingLimit = 0xfff;  ///< Volume factor clipping limit (4095)
+  uint16_t ramp_frames = A2DP_VOLUME_RAMP_FRAMES;  ///< Length of the gain ramps
+  volatile bool is_fade_out = false;    ///< Target gain is 0
+  volatile bool is_fade_reset = false;  ///< Set the gain to 0 w/o ramp
+  bool is_ramp_active = false;          ///< Ramp gain has been initialized
+  int32_t ramp_factor = -1;             ///< Target gain in volume factor units
+  int32_t ramp_target = 0;  ///< Target gain: 1 << 30 is unity
+  int32_t ramp_gain = 0;    ///< Actual gain: 1 << 30 is unity
+  int32_t ramp_step = 0;    ///< Gain change per frame
+
+  /**
+   * @brief Provides the gain which we ramp to in volume factor units
+   */
+  int32_t target_factor() {
+    return is_fade_out ? 0 : (is_volume_used ? volumeFactor : volumeFactorMax);
+  }
+
+  /**
+   * @brief Determines the target gain and the step of the ramp
+   * @return True if the gain is changing
+   */
+  bool update_ramp() {
+    int32_t factor = target_factor();
+    bool is_reset = is_fade_reset;
+    if (is_reset) {
+      is_fade_reset = false;
+      ramp_gain = 0;
+      is_ramp_active = true;
+    }
+    if (factor != ramp_factor || is_reset) {
+      ramp_factor = factor;
+      ramp_target = ((int64_t)factor << 30) / volumeFactorMax;
+      // the first block starts w/o ramp
+      if (!is_ramp_active) ramp_gain = ramp_target;
+      is_ramp_active = true;
+      if (ramp_frames > 0) {
+        ramp_step = (ramp_target - ramp_gain) / ramp_frames;
+        if (ramp_step == 0) ramp_step = ramp_target > ramp_gain ? 1 : -1;
+      }
+    }
+    if (ramp_frames == 0) ramp_gain = ramp_target;
+    return ramp_gain != ramp_target;
+  }
+
+  /**
+   * @brief Processes the frames of the actual ramp with a per frame gain
+   * @return Number of processed frames
+   */
+  uint16_t apply_ramp(const Frame* src, Frame* dst, uint16_t frameCount,
+                      bool swap) {
+    int32_t steps = (ramp_target - ramp_gain) / ramp_step;
+    uint16_t n = steps < frameCount ? steps : frameCount;
+    if (swap) {
+      if (mono_downmix)
+        transform_frames<true, true, false, false>(src, dst, n, 0);
+      else
+        transform_frames<true, false, false, false>(src, dst, n, 0);
+    } else if (mono_downmix) {
+      transform_frames<false, true, false, false>(src, dst, n, 0);
+    } else if (src != dst) {
+      memmove(dst, src, n * sizeof(Frame));
+    }
+    int32_t gain = ramp_gain;
+    for (int i = 0; i < n; i++) {
+      gain += ramp_step;
+      int32_t g = gain >> 15;
+      dst[i].channel1 = clip((dst[i].channel1 * g) >> 15);
+      dst[i].channel2 = clip((dst[i].channel2 * g) >> 15);
+    }
+    // the target is reached: the rest is processed with the steady gain
+    ramp_gain = n == steps ? ramp_target : gain;
+    return n;
+  }
 
   /**
    * @brief Clips audio sample value to prevent overflow
    * @param value Input audio sample value
    * @return Clipped value within valid 16-bit range (-32768 to 32767)
    */
-  int32_t clip(int32_t value) {
-    int32_t result = value;
-    if (value < -32768) result = -32768;
-    if (value > 32767) result = 32767;
-    return result;
+  inline int32_t clip(int32_t value) {
+    // simple conditional expressions w/o side effects, so that the compiler
+    // can use min/max (clamp) instructions instead of branches
+    return value < -32768 ? -32768 : (value > 32767 ? 32767 : value);
+  }
+
+  /**
+   * @brief Determines the shift which is equivalent to a division by
+   * volumeFactorMax
+   * @return Number of bits or -1 if volumeFactorMax is not a power of 2
+   */
+  int volume_factor_shift() {
+    if (volumeFactorMax <= 0 || (volumeFactorMax & (volumeFactorMax - 1)) != 0)
+      return -1;
+    return __builtin_ctz(volumeFactorMax);
+  }
+
+  /**
+   * @brief Scales a single sample with the actual volume factor
+   * @tparam IsShift True to replace the division by a shift
+   */
+  template <bool IsShift>
+  inline int32_t scale(int32_t value, int shift) {
+    value *= volumeFactor;
+    if (IsShift) {
+      // negative values are rounded towards 0 like by the division
+      return clip((value + ((value >> 31) & ((1 << shift) - 1))) >> shift);
+    }
+    return clip(value / volumeFactorMax);
+  }
+
+  /**
+   * @brief Applies the volume to an array of interleaved samples. The loop
+   * does not depend on the channel layout, so it can be vectorized.
+   */
+  template <bool IsShift>
+  void scale_samples(const void* src, void* dst, int sampleCount, int shift) {
+    // the decoded PCM buffers are 16 bit aligned
+    const int16_t* in = (const int16_t*)src;
+    int16_t* out = (int16_t*)dst;
+    for (int i = 0; i < sampleCount; i++) {
+      out[i] = scale<IsShift>(in[i], shift);
+    }
+  }
+
+  /**
+   * @brief Selects the frame loop for the actual volume settings
+   */
+  template <bool IsSwap, bool IsMono>
+  void transform(const Frame* src, Frame* dst, uint16_t frameCount) {
+    if (!is_volume_used) {
+      transform_frames<IsSwap, IsMono, false, false>(src, dst, frameCount, 0);
+      return;
+    }
+    int shift = volume_factor_shift();
+    if (shift >= 0)
+      transform_frames<IsSwap, IsMono, true, true>(src, dst, frameCount, shift);
+    else
+      transform_frames<IsSwap, IsMono, true, false>(src, dst, frameCount,
+                                                    shift);
+  }
+
+  /**
+   * @brief Processes the frames: the frame is completely read before it is
+   * written, so src and dst can be identical
+   */
+  template <bool IsSwap, bool IsMono, bool IsVolume, bool IsShift>
+  void transform_frames(const Frame* src, Frame* dst, uint16_t frameCount,
+                        int shift) {
+    for (int i = 0; i < frameCount; i++) {
+      int32_t pcmLeft = IsSwap ? src[i].channel2 : src[i].channel1;
+      int32_t pcmRight = IsSwap ? src[i].channel1 : src[i].channel2;
+      // if mono -> we provide the same output on both channels
+      if (IsMono) {
+        pcmRight = pcmLeft = (pcmLeft + pcmRight) / 2;
+      }
+      if (IsVolume) {
+        pcmLeft = scale<IsShift>(pcmLeft, shift);
+        pcmRight = scale<IsShift>(pcmRight, shift);
+      }
+      dst[i].channel1 = pcmLeft;
+      dst[i].channel2 = pcmRight;
+    }
   }
 };
 
@@ -165,6 +408,11 @@ class A2DPDefaultVolumeControl : public A2DPVolumeControl {
     volumeFactorClippingLimit = limit;
   };
 
+  /**
+   * @brief The fused processing is provided by A2DPVolumeControl
+   */
+  bool supports_fused() override { return true; }
+
  protected:
   /**
    * @brief Sets the volume using exponential curve calculation
@@ -207,6 +455,11 @@ class A2DPSimpleExponentialVolumeControl : public A2DPVolumeControl {
     volumeFactorClippingLimit = limit;
   };
 
+  /**
+   * @brief The fused processing is provided by A2DPVolumeControl
+   */
+  bool supports_fused() override { return true; }
+
  protected:
   /**
    * @brief Sets the volume using simple exponential calculation
@@ -234,6 +487,11 @@ class A2DPLinearVolumeControl : public A2DPVolumeControl {
    */
   A2DPLinearVolumeControl() { volumeFactorMax = 128; }
 
+  /**
+   * @brief The fused processing is provided by A2DPVolumeControl
+   */
+  bool supports_fused() override { return true; }
+
  protected:
   /**
    * @brief Sets the volume using direct linear mapping
@@ -268,6 +526,38 @@ class A2DPNoVolumeControl : public A2DPVolumeControl {
    */
   void update_audio_data(Frame* data, uint16_t frameCount) override {}
 
+  /**
+   * @brief The data is never changed in place
+   * @return Always true
+   */
+  bool is_unity() override { return true; }
+
+  /**
+   * @brief Both update methods leave the volume unchanged
+   */
+  bool supports_fused() override { return true; }
+
+  /**
+   * @brief Only swaps the channels or copies the data
+   * @param src Pointer to the input frames
+   * @param dst Pointer to the output frames: can be identical with src
+   * @param frameCount Number of frames to process
+   * @param swap True to swap the left and right channel
+   */
+  void update_audio_data(const Frame* src, Frame* dst, uint16_t frameCount,
+                         bool swap) override {
+    if (src == nullptr || dst == nullptr) return;
+    if (swap) {
+      for (int i = 0; i < frameCount; i++) {
+        int16_t temp = src[i].channel1;
+        dst[i].channel1 = src[i].channel2;
+        dst[i].channel2 = temp;
+      }
+    } else if (src != dst) {
+      memmove(dst, src, frameCount * sizeof(Frame));
+    }
+  }
+
   /**
    * @brief Override that does nothing - no volume setting
    * @param volume Volume level (unused)
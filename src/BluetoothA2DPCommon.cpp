@@ -478,9 +478,22 @@ esp_err_t BluetoothA2DPCommon::bluedroid_init() {
 
 void BluetoothA2DPCommon::app_task_start_up() {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
+  // one slot for each queue entry and for the message which is processed:
+  // BT callbacks might still use slots after end(false), so the pool is only
+  // rebuilt when the event_queue_size has changed
+  int slots = A2DP_LANE_COUNT * event_queue_size + 1;
+  if (!app_msg_pool || app_msg_pool.size() != slots) {
+    if (!app_msg_pool.begin(slots, sizeof(bt_app_param_t))) {
+      ESP_LOGW(BT_APP_TAG, "%s: message pool not available", __func__);
+    }
+  }
+
   if (app_task_queue == nullptr) {
     app_task_queue = xQueueCreate(event_queue_size, sizeof(bt_app_msg_t));
   }
+  if (app_task_info_queue == nullptr) {
+    app_task_info_queue = xQueueCreate(event_queue_size, sizeof(bt_app_msg_t));
+  }
 
   if (app_task_handle == nullptr) {
     if (xTaskCreatePinnedToCore(ccall_bt_app_task_handler, "BtAppT",
@@ -498,11 +511,28 @@ void BluetoothA2DPCommon::app_task_shut_down(void) {
     app_task_handle = nullptr;
   }
 
+  // release the parameters of the messages which were not processed
+  bt_app_msg_t msg;
+  while (app_receive_msg(&msg)) {
+    app_free_msg(&msg);
+  }
+
   if (app_task_queue != nullptr) {
     QueueHandle_t queue = app_task_queue;
     app_task_queue = nullptr;
     vQueueDelete(queue);
   }
+  if (app_task_info_queue != nullptr) {
+    QueueHandle_t queue = app_task_info_queue;
+    app_task_info_queue = nullptr;
+    vQueueDelete(queue);
+  }
+}
+
+void BluetoothA2DPCommon::app_free_msg(bt_app_msg_t* msg) {
+  if (msg->param) {
+    app_msg_pool.free(msg->param);
+  }
 }
 
 void BluetoothA2DPCommon::app_task_handler(void* arg) {
@@ -510,16 +540,18 @@ void BluetoothA2DPCommon::app_task_handler(void* arg) {
   bt_app_msg_t msg;
 
   for (;;) {
-    while (app_task_queue == nullptr) {
+    while (app_task_queue == nullptr || app_task_info_queue == nullptr) {
       ESP_LOGW(BT_APP_TAG, "app_task_queue is null");
       delay_ms(1000);
     }
 
-    /* receive message from work queue and handle it */
-    if (pdTRUE ==
-        xQueueReceive(app_task_queue, &msg, (TickType_t)portMAX_DELAY)) {
-      ESP_LOGD(BT_APP_TAG, "%s, signal: 0x%x, event: 0x%x", __func__, msg.sig,
-               msg.event);
+    /* wait for the notification of app_send_msg() */
+    ulTaskNotifyTake(pdTRUE, (TickType_t)portMAX_DELAY);
+
+    /* receive messages from the work queues and handle them */
+    while (app_receive_msg(&msg)) {
+      ESP_LOGD(BT_APP_TAG, "%s, signal: 0x%x, event: 0x%x, lane: %d",
+               __func__, msg.sig, msg.event, msg.lane);
 
       switch (msg.sig) {
         case BT_APP_SIG_WORK_DISPATCH:
@@ -531,31 +563,171 @@ void BluetoothA2DPCommon::app_task_handler(void* arg) {
       }
 
       if (msg.param) {
-        free(msg.param);
+        app_msg_pool.free(msg.param);
       }
     }
   }
 }
 
+bool BluetoothA2DPCommon::app_receive_msg(bt_app_msg_t* msg) {
+  // the control lane is always drained first
+  for (int lane = 0; lane < A2DP_LANE_COUNT; lane++) {
+    QueueHandle_t queue = app_lane_queue(lane);
+    if (queue != nullptr && xQueueReceive(queue, msg, 0) == pdTRUE) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void BluetoothA2DPCommon::app_work_dispatched(bt_app_msg_t* msg) {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
+  uint32_t start_us = esp_timer_get_time();
   if (msg->cb) {
     msg->cb(msg->event, msg->param);
   }
+  app_record_latency(msg, start_us, esp_timer_get_time());
+}
+
+void BluetoothA2DPCommon::app_record_latency(bt_app_msg_t* msg,
+                                             uint32_t start_us,
+                                             uint32_t end_us) {
+  uint32_t queue_us = start_us - msg->time_us;
+  uint32_t run_us = end_us - start_us;
+  uint32_t ms = queue_us / 1000;
+  int bucket = ms == 0 ? 0 : 32 - __builtin_clz(ms);
+  if (bucket >= A2DP_EVENT_LATENCY_BUCKETS) {
+    bucket = A2DP_EVENT_LATENCY_BUCKETS - 1;
+  }
+
+  taskENTER_CRITICAL(&app_stats_lock);
+  // find the entry of the event type: the last one collects the overflow
+  int idx = 0;
+  while (idx < app_latency_count &&
+         (app_latency_stats[idx].cb != msg->cb ||
+          app_latency_stats[idx].event != msg->event)) {
+    idx++;
+  }
+  if (idx == app_latency_count) {
+    if (idx < A2DP_EVENT_LATENCY_TYPES - 1) {
+      app_latency_stats[idx] = A2DPEventLatencyStats();
+      app_latency_stats[idx].cb = msg->cb;
+      app_latency_stats[idx].event = msg->event;
+      app_latency_stats[idx].lane = msg->lane;
+      app_latency_count++;
+    } else {
+      idx = A2DP_EVENT_LATENCY_TYPES - 1;
+      if (app_latency_count < A2DP_EVENT_LATENCY_TYPES) {
+        app_latency_stats[idx] = A2DPEventLatencyStats();
+        app_latency_stats[idx].event = 0xFFFF;
+        app_latency_count = A2DP_EVENT_LATENCY_TYPES;
+      }
+    }
+  }
+  A2DPEventLatencyStats& stats = app_latency_stats[idx];
+  stats.count++;
+  stats.total_us += queue_us;
+  if (queue_us > stats.max_us) stats.max_us = queue_us;
+  if (run_us > stats.max_run_us) stats.max_run_us = run_us;
+  stats.buckets[bucket]++;
+  taskEXIT_CRITICAL(&app_stats_lock);
+}
+
+A2DPEventLatencyStats BluetoothA2DPCommon::get_event_latency_stats(int idx) {
+  A2DPEventLatencyStats result;
+  if (idx < 0 || idx >= app_latency_count) return result;
+  taskENTER_CRITICAL(&app_stats_lock);
+  result = app_latency_stats[idx];
+  taskEXIT_CRITICAL(&app_stats_lock);
+  return result;
+}
+
+void BluetoothA2DPCommon::reset_event_latency_stats() {
+  taskENTER_CRITICAL(&app_stats_lock);
+  app_latency_count = 0;
+  taskEXIT_CRITICAL(&app_stats_lock);
+}
+
+void BluetoothA2DPCommon::log_event_latency_stats() {
+  for (int lane = 0; lane < A2DP_LANE_COUNT; lane++) {
+    A2DPEventLaneStats lane_stats = get_event_lane_stats((A2DPEventLane)lane);
+    ESP_LOGI(BT_APP_TAG,
+             "lane %d: sent %u, dropped %u, depth %u, max depth %u (event "
+             "0x%x at %lu ms)",
+             lane, (unsigned)lane_stats.sent, (unsigned)lane_stats.dropped,
+             lane_stats.depth, lane_stats.depth_max,
+             lane_stats.depth_max_event, lane_stats.depth_max_ms);
+  }
+  for (int j = 0; j < get_event_latency_count(); j++) {
+    A2DPEventLatencyStats stats = get_event_latency_stats(j);
+    if (stats.count == 0) continue;
+    char hist[A2DP_EVENT_LATENCY_BUCKETS * 11 + 1] = {0};
+    int pos = 0;
+    for (int b = 0; b < A2DP_EVENT_LATENCY_BUCKETS; b++) {
+      pos += snprintf(hist + pos, sizeof(hist) - pos, " %u",
+                      (unsigned)stats.buckets[b]);
+    }
+    ESP_LOGI(BT_APP_TAG,
+             "lane %d event 0x%x cb %p: count %u, avg %u us, max %u us, max "
+             "run %u us, histogram:%s",
+             stats.lane, stats.event, stats.cb, (unsigned)stats.count,
+             (unsigned)(stats.total_us / stats.count), (unsigned)stats.max_us,
+             (unsigned)stats.max_run_us, hist);
+  }
+}
+
+QueueHandle_t BluetoothA2DPCommon::app_lane_queue(uint16_t lane) {
+  return lane == A2DP_LANE_INFO ? app_task_info_queue : app_task_queue;
 }
 
 bool BluetoothA2DPCommon::app_send_msg(bt_app_msg_t* msg) {
-  if (msg == nullptr || app_task_queue == nullptr) {
+  if (msg == nullptr) {
+    return false;
+  }
+  if (msg->lane >= A2DP_LANE_COUNT) msg->lane = A2DP_LANE_CONTROL;
+  QueueHandle_t queue = app_lane_queue(msg->lane);
+  if (queue == nullptr) {
     return false;
   }
 
-  if (xQueueSend(app_task_queue, msg, 10 / portTICK_PERIOD_MS) != pdTRUE) {
-    ESP_LOGE(BT_APP_TAG, "%s xQueue send failed", __func__);
+  A2DPEventLaneStats& stats = app_lane_stats[msg->lane];
+  msg->time_us = esp_timer_get_time();
+  if (xQueueSend(queue, msg, 10 / portTICK_PERIOD_MS) != pdTRUE) {
+    ESP_LOGE(BT_APP_TAG, "%s xQueue send failed (lane %d)", __func__,
+             msg->lane);
+    stats.dropped++;
     return false;
   }
+  stats.sent++;
+  uint16_t depth = uxQueueMessagesWaiting(queue);
+  if (depth > stats.depth_max) {
+    stats.depth_max = depth;
+    stats.depth_max_ms = get_millis();
+    stats.depth_max_event = msg->event;
+  }
+
+  if (app_task_handle != nullptr) {
+    xTaskNotifyGive(app_task_handle);
+  }
   return true;
 }
 
+A2DPEventLaneStats BluetoothA2DPCommon::get_event_lane_stats(
+    A2DPEventLane lane) {
+  A2DPEventLaneStats result;
+  if (lane >= A2DP_LANE_COUNT) return result;
+  result = app_lane_stats[lane];
+  QueueHandle_t queue = app_lane_queue(lane);
+  result.depth = queue == nullptr ? 0 : uxQueueMessagesWaiting(queue);
+  return result;
+}
+
+void BluetoothA2DPCommon::reset_event_lane_stats() {
+  for (int lane = 0; lane < A2DP_LANE_COUNT; lane++) {
+    app_lane_stats[lane] = A2DPEventLaneStats();
+  }
+}
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
 
 /// converts a esp_a2d_audio_state_t to a string
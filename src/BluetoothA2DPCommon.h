@@ -61,6 +61,7 @@ using namespace esp_i2s;
 #include "freertos/task.h"
 #include "freertos/timers.h"
 #include "A2DPVolumeControl.h"
+#include "A2DPMessagePool.h"
 #include "esp_a2dp_api.h"
 #include "esp_avrc_api.h"
 #include "esp_bt.h"
@@ -144,10 +145,22 @@ typedef void (*app_callback_t)(uint16_t event, void *param);
 typedef struct {
   uint16_t sig;      /*!< signal to app_task */
   uint16_t event;    /*!< message event id */
+  uint16_t lane;     /*!< A2DPEventLane which is used to queue the message */
+  uint32_t time_us;  /*!< time when the message was queued */
   app_callback_t cb; /*!< context switch callback */
   void *param;       /*!< parameter area needs to be last */
 } bt_app_msg_t;
 
+/** @brief Parameters which are passed to the app task: used to determine the
+ * slot size of the message pool */
+typedef union {
+  esp_a2d_cb_param_t a2d;
+  esp_avrc_ct_cb_param_t avrc_ct;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  esp_avrc_tg_cb_param_t avrc_tg;
+#endif
+} bt_app_param_t;
+
 #define BT_AV_TAG "BT_AV"
 #define BT_RC_CT_TAG "RCCT"
 #define BT_APP_TAG "BT_API"
@@ -181,6 +194,58 @@ extern "C" void ccall_av_hdl_avrc_tg_evt(uint16_t event, void *p_param);
  */
 enum ReconnectStatus { NoReconnect, AutoReconnect, IsReconnecting };
 
+/**
+ * @brief Priority lanes of the app task: the control lane (connection and
+ * audio state) is always processed before the info lane (AVRC events)
+ * @ingroup a2dp
+ */
+enum A2DPEventLane { A2DP_LANE_CONTROL, A2DP_LANE_INFO, A2DP_LANE_COUNT };
+
+/**
+ * @brief Statistics of an event lane of the app task
+ * @ingroup a2dp
+ */
+struct A2DPEventLaneStats {
+  /// number of messages which were queued
+  uint32_t sent = 0;
+  /// number of messages which could not be queued
+  uint32_t dropped = 0;
+  /// number of messages which are currently waiting
+  uint16_t depth = 0;
+  /// max number of messages which were waiting at the same time
+  uint16_t depth_max = 0;
+  /// time in ms when the max depth was reached
+  unsigned long depth_max_ms = 0;
+  /// event id of the message which reached the max depth
+  uint16_t depth_max_event = 0;
+};
+
+/**
+ * @brief Latency statistics of an event type of the app task: the queue time
+ * is measured from app_send_msg() to the start of the processing in the app
+ * task. The event type is identified by the callback and the event id.
+ * @ingroup a2dp
+ */
+struct A2DPEventLatencyStats {
+  /// callback which processes the event: nullptr for the overflow entry
+  app_callback_t cb = nullptr;
+  /// A2DPEventLane of the event
+  uint16_t lane = 0;
+  /// event id
+  uint16_t event = 0;
+  /// number of processed messages
+  uint32_t count = 0;
+  /// sum of the queue times in us
+  uint64_t total_us = 0;
+  /// max queue time in us
+  uint32_t max_us = 0;
+  /// max processing time in us
+  uint32_t max_run_us = 0;
+  /// bucket 0 counts the queue times < 1 ms, bucket i the ones < 2^i ms; the
+  /// last bucket counts all longer ones
+  uint32_t buckets[A2DP_EVENT_LATENCY_BUCKETS] = {};
+};
+
 /**
  * @brief Common Bluetooth A2DP functions
  * @author Phil Schatzmann
@@ -314,9 +379,32 @@ class BluetoothA2DPCommon {
   /// and audio queue): default is 1
   void set_task_core(BaseType_t core) { task_core = core; }
 
-  /// Defines the queue size of the event task
+  /// Defines the queue size of the event task (for each lane)
   void set_event_queue_size(int size) { event_queue_size = size; }
 
+  /// Provides the queue statistics of the indicated event lane
+  A2DPEventLaneStats get_event_lane_stats(A2DPEventLane lane);
+
+  /// Resets the sent, dropped and max depth counters of all event lanes
+  void reset_event_lane_stats();
+
+  /// Number of event types for which the latency has been recorded
+  int get_event_latency_count() { return app_latency_count; }
+
+  /// Provides the latency statistics of the indicated event type (0 to
+  /// get_event_latency_count() - 1)
+  A2DPEventLatencyStats get_event_latency_stats(int idx);
+
+  /// Resets the latency statistics of all event types
+  void reset_event_latency_stats();
+
+  /// Logs the latency statistics and the queue depths with ESP_LOGI
+  void log_event_latency_stats();
+
+  /// Number of event parameters which needed to be allocated on the heap
+  /// because the message pool was exhausted
+  uint32_t get_message_pool_misses() { return app_msg_pool.pool_misses(); }
+
   /// Defines the stack size of the event task (in bytes)
   void set_event_stack_size(int size) { event_stack_size = size; }
 
@@ -419,8 +507,16 @@ class BluetoothA2DPCommon {
   std::vector<esp_avrc_rn_event_ids_t> avrc_rn_events = {
       ESP_AVRC_RN_VOLUME_CHANGE};
 
+  // control lane
   QueueHandle_t app_task_queue = nullptr;
+  // info lane
+  QueueHandle_t app_task_info_queue = nullptr;
+  A2DPEventLaneStats app_lane_stats[A2DP_LANE_COUNT];
+  A2DPEventLatencyStats app_latency_stats[A2DP_EVENT_LATENCY_TYPES];
+  int app_latency_count = 0;
+  portMUX_TYPE app_stats_lock = portMUX_INITIALIZER_UNLOCKED;
   TaskHandle_t app_task_handle = nullptr;
+  A2DPMessagePool app_msg_pool;
   std::map<int, void*> references;
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 1)
@@ -452,6 +548,12 @@ class BluetoothA2DPCommon {
   virtual void app_task_start_up();
   virtual void app_task_shut_down();
   virtual bool app_send_msg(bt_app_msg_t *msg);
+  virtual QueueHandle_t app_lane_queue(uint16_t lane);
+  virtual bool app_receive_msg(bt_app_msg_t *msg);
+  /// releases the memory of a message which will not be processed
+  virtual void app_free_msg(bt_app_msg_t *msg);
+  virtual void app_record_latency(bt_app_msg_t *msg, uint32_t start_us,
+                                  uint32_t end_us);
   virtual void app_task_handler(void *arg);
   virtual void app_work_dispatched(bt_app_msg_t *msg);
   virtual bool isSource() = 0;
@@ -105,8 +105,33 @@ bool BluetoothA2DPOutputLegacy::begin() {
 
 size_t BluetoothA2DPOutputLegacy::write(const uint8_t *data, size_t item_size) {
   size_t i2s_bytes_written = 0;
+#if A2DP_LEGACY_I2S_SUPPORT
+  i2s_write_ticks(data, item_size, portMAX_DELAY);
+  i2s_bytes_written = item_size;
+#endif
+  return i2s_bytes_written;
+}
+
+size_t BluetoothA2DPOutputLegacy::try_write(const uint8_t *data,
+                                            size_t item_size) {
+#if A2DP_LEGACY_I2S_SUPPORT
+  // the DAC conversion is done in place and the expanded output does not
+  // report the input bytes, so we must not write partially
+  if ((this->i2s_config.mode & I2S_MODE_DAC_BUILT_IN) ||
+      i2s_config.bits_per_sample != I2S_BITS_PER_SAMPLE_16BIT) {
+    return write(data, item_size);
+  }
+  return i2s_write_ticks(data, item_size, 0);
+#else
+  return 0;
+#endif
+}
 
 #if A2DP_LEGACY_I2S_SUPPORT
+size_t BluetoothA2DPOutputLegacy::i2s_write_ticks(const uint8_t *data,
+                                                  size_t item_size,
+                                                  TickType_t ticks) {
+  size_t i2s_bytes_written = 0;
   if (this->i2s_config.mode & I2S_MODE_DAC_BUILT_IN) {
     // special case for internal DAC output, the incomming PCM buffer needs
     // to be converted from signed 16bit to unsigned
@@ -118,16 +143,16 @@ size_t BluetoothA2DPOutputLegacy::write(const uint8_t *data, size_t item_size) {
     // the buffer is anyway static block of memory possibly overwritten by
     // next incomming data.
 
+    // adding 0x8000 is the same as flipping the sign bit
     for (int i = 0; i < item_size / 2; i++) {
-      int16_t sample = data[i * 2] | data[i * 2 + 1] << 8;
-      data16[i] = sample + 0x8000;
+      data16[i] ^= 0x8000;
     }
   }
 
   if (i2s_config.bits_per_sample == I2S_BITS_PER_SAMPLE_16BIT) {
     // standard logic with 16 bits
     if (i2s_write(i2s_port, (void *)data, item_size, &i2s_bytes_written,
-                  portMAX_DELAY) != ESP_OK) {
+                  ticks) != ESP_OK) {
       ESP_LOGE(BT_AV_TAG, "i2s_write has failed");
     }
   } else {
@@ -136,7 +161,7 @@ size_t BluetoothA2DPOutputLegacy::write(const uint8_t *data, size_t item_size) {
       if (i2s_write_expand(i2s_port, (void *)data, item_size,
                            I2S_BITS_PER_SAMPLE_16BIT,
                            i2s_config.bits_per_sample, &i2s_bytes_written,
-                           portMAX_DELAY) != ESP_OK) {
+                           ticks) != ESP_OK) {
         ESP_LOGE(BT_AV_TAG, "i2s_write has failed");
       }
     } else {
@@ -145,10 +170,9 @@ size_t BluetoothA2DPOutputLegacy::write(const uint8_t *data, size_t item_size) {
     }
   }
 
-  i2s_bytes_written = item_size;
-#endif
   return i2s_bytes_written;
 }
+#endif
 
 void BluetoothA2DPOutputLegacy::end() {
 #if A2DP_LEGACY_I2S_SUPPORT
@@ -216,6 +240,24 @@ size_t BluetoothA2DPOutputAudioTools::write(const uint8_t *data, size_t item_siz
 }
 
 
+int BluetoothA2DPOutputAudioTools::available_for_write() {
+  int result = -1;
+#if A2DP_I2S_AUDIOTOOLS
+  // AudioTools reports the actual capacity
+  if (p_audio_print != nullptr) {
+    result = p_print->availableForWrite();
+  } else
+#endif
+#if A2DP_I2S_AUDIOTOOLS || defined(ARDUINO)
+  // plain Print returns 0 if this is not implemented
+  if (p_print != nullptr) {
+    int avail = p_print->availableForWrite();
+    result = avail > 0 ? avail : -1;
+  }
+#endif
+  return result;
+}
+
 void BluetoothA2DPOutputAudioTools::end() {
 #if A2DP_I2S_AUDIOTOOLS
   ESP_LOGI(BT_AV_TAG, "%s", __func__);
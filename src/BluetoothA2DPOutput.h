@@ -27,6 +27,18 @@ class BluetoothA2DPOutput {
   virtual void set_sample_rate(int rate) = 0;
   virtual void set_output_active(bool active) = 0;
 
+  /// Number of bytes which can be written w/o blocking: -1 if unknown
+  virtual int available_for_write() { return -1; }
+
+  /// Writes only as much data as can be accepted w/o blocking. If the
+  /// capacity is unknown this is the same as write().
+  virtual size_t try_write(const uint8_t *data, size_t len) {
+    int avail = available_for_write();
+    if (avail < 0) return write(data, len);
+    if (avail == 0) return 0;
+    return write(data, len < (size_t)avail ? len : avail);
+  }
+
 #if A2DP_I2S_AUDIOTOOLS
   /// Not implemented
   virtual void set_output(audio_tools::AudioOutput &output) {}
@@ -74,6 +86,7 @@ class BluetoothA2DPOutputAudioTools : public BluetoothA2DPOutput {
   void end() override;
   void set_sample_rate(int rate) override;
   void set_output_active(bool active) override;
+  int available_for_write() override;
 
   operator bool() { 
 #if A2DP_I2S_AUDIOTOOLS || defined(ARDUINO)
@@ -134,6 +147,13 @@ class BluetoothA2DPOutputPrint : public BluetoothA2DPOutput {
   void end() override {}
   void set_sample_rate(int rate) override {};
   void set_output_active(bool active) override {};
+  /// Print returns 0 when availableForWrite() is not implemented, so we
+  /// treat 0 as unknown
+  int available_for_write() override {
+    if (p_print == nullptr) return 0;
+    int result = p_print->availableForWrite();
+    return result > 0 ? result : -1;
+  }
 
   operator bool() { 
     return p_print != nullptr; 
@@ -159,6 +179,7 @@ class BluetoothA2DPOutputLegacy : public BluetoothA2DPOutput {
   BluetoothA2DPOutputLegacy();
   bool begin() override;
   size_t write(const uint8_t *data, size_t len) override;
+  size_t try_write(const uint8_t *data, size_t len) override;
   void end() override;
   void set_sample_rate(int rate) override;
   void set_output_active(bool active) override;
@@ -191,6 +212,8 @@ class BluetoothA2DPOutputLegacy : public BluetoothA2DPOutput {
   i2s_pin_config_t pin_config;
   i2s_channel_t i2s_channels = I2S_CHANNEL_STEREO;
   i2s_port_t i2s_port = I2S_NUM_0;
+
+  size_t i2s_write_ticks(const uint8_t *data, size_t len, TickType_t ticks);
 #endif
 };
 
@@ -242,6 +265,20 @@ class BluetoothA2DPOutputDefault : public BluetoothA2DPOutput {
       out_legacy.set_output_active(active);
   }
 
+  int available_for_write() override {
+    if (out_tools)
+      return out_tools.available_for_write();
+    else
+      return out_legacy.available_for_write();
+  }
+
+  size_t try_write(const uint8_t *data, size_t len) override {
+    if (out_tools)
+      return out_tools.try_write(data, len);
+    else
+      return out_legacy.try_write(data, len);
+  }
+
 #if A2DP_I2S_AUDIOTOOLS
   /// Output AudioStream using AudioTools library
   void set_output(audio_tools::AudioOutput &output) override  { out_tools.set_output(output); }
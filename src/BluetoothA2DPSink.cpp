@@ -39,6 +39,22 @@ extern "C" void ccall_av_hdl_avrc_evt(uint16_t event, void *param) {
   }
 }
 
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+extern "C" void ccall_av_hdl_coalesced_evt(uint16_t event, void *param) {
+  ESP_LOGD(BT_AV_TAG, "%s", __func__);
+  if (actual_bluetooth_a2dp_sink) {
+    actual_bluetooth_a2dp_sink->av_hdl_coalesced_evt(event);
+  }
+}
+
+extern "C" void ccall_app_coalesced_timer(TimerHandle_t timer) {
+  if (actual_bluetooth_a2dp_sink) {
+    intptr_t idx = (intptr_t)pvTimerGetTimerID(timer);
+    actual_bluetooth_a2dp_sink->app_coalesced_timer((A2DPCoalescedEvent)idx);
+  }
+}
+#endif
+
 extern "C" void ccall_av_hdl_a2d_evt(uint16_t event, void *param) {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
   if (actual_bluetooth_a2dp_sink) {
@@ -80,6 +96,8 @@ BluetoothA2DPSink::~BluetoothA2DPSink() {
   if (app_task_queue != nullptr) {
     end();
   }
+  // the resampler might have been used w/o start()
+  free(resampled_frames);
 }
 
 void BluetoothA2DPSink::end(bool release_memory) {
@@ -88,15 +106,53 @@ void BluetoothA2DPSink::end(bool release_memory) {
   if (is_autoreconnect_allowed) {
      is_autoreconnect_allowed = false;
      // https://github.com/pschatzmann/ESP32-A2DP/issues/750
-     if (release_memory && !avrc_connection_state) delay(2100); // give it some time to end
+     if (release_memory && !avrc_connection_state) delay_ms(2100); // give it some time to end
   }
 
 
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  // no new timers for coalesced events: BT callbacks might still arrive
+  is_coalesce_stopped = true;
+#endif
+
   BluetoothA2DPCommon::end(release_memory);
 
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  // the app task is gone, so the timers can be deleted: the queued
+  // deliveries were deleted with the queues and only the rate limits are kept
+  for (int j = 0; j < A2DP_EVT_COALESCED_COUNT; j++) {
+    CoalescedEvent &evt = coalesced_events[j];
+    if (evt.timer != nullptr) {
+      xTimerDelete(evt.timer, portMAX_DELAY);
+      evt.timer = nullptr;
+    }
+    taskENTER_CRITICAL(&coalesce_lock);
+    evt.cb = nullptr;
+    evt.pending = false;
+    evt.last_ms = 0;
+    taskEXIT_CRITICAL(&coalesce_lock);
+  }
+#endif
+
+  // the app task is gone: unprocessed metadata messages can not release
+  // their texts any more
+  meta_arena_refs[0] = 0;
+  meta_arena_refs[1] = 0;
+  meta_arena_used = 0;
+
   if (is_output) {
     out->end();
   }
+
+  is_output_resampling = false;
+  is_output_rate_changed = false;
+  output_resampler.end();
+  if (resampled_frames != nullptr) {
+    free(resampled_frames);
+    resampled_frames = nullptr;
+    resampled_frames_size = 0;
+  }
+  output_rate_set = 0;
 }
 
 void BluetoothA2DPSink::set_stream_reader(void (*callBack)(const uint8_t *,
@@ -176,6 +232,9 @@ void BluetoothA2DPSink::start(const char *name) {
 
   // create application task
   app_task_start_up();
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  is_coalesce_stopped = false;
+#endif
 
   // Bluetooth device name, connection mode and profile set up
   app_work_dispatch(ccall_av_hdl_stack_evt, BT_APP_EVT_STACK_UP, nullptr, 0);
@@ -334,30 +393,160 @@ bool BluetoothA2DPSink::app_work_dispatch(app_callback_t p_cback,
 
   msg.sig = APP_SIG_WORK_DISPATCH;
   msg.event = event;
+  msg.lane = app_event_lane(p_cback);
   msg.cb = p_cback;
 
   if (param_len == 0) {
     return app_send_msg(&msg);
   } else if (p_params && param_len > 0) {
-    if ((msg.param = malloc(param_len)) != nullptr) {
+    if ((msg.param = app_msg_pool.alloc(param_len)) != nullptr) {
       memcpy(msg.param, p_params, param_len);
-      return app_send_msg(&msg);
+      if (app_send_msg(&msg)) return true;
+      app_msg_pool.free(msg.param);
     }
   }
 
   return false;
 }
 
+A2DPEventLane BluetoothA2DPSink::app_event_lane(app_callback_t p_cback) {
+  // AVRC events must not delay the connection and audio state changes
+  if (p_cback == ccall_av_hdl_avrc_evt) return A2DP_LANE_INFO;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  if (p_cback == ccall_av_hdl_avrc_tg_evt) return A2DP_LANE_INFO;
+  if (p_cback == ccall_av_hdl_coalesced_evt) return A2DP_LANE_INFO;
+#endif
+  return A2DP_LANE_CONTROL;
+}
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+
+bool BluetoothA2DPSink::app_work_coalesce(A2DPCoalescedEvent idx,
+                                          app_callback_t p_cback,
+                                          uint16_t event, void *p_params,
+                                          int param_len) {
+  CoalescedEvent &evt = coalesced_events[idx];
+  if (is_coalesce_stopped || param_len > (int)sizeof(bt_app_param_t)) {
+    return app_work_dispatch(p_cback, event, p_params, param_len);
+  }
+
+  // store the latest value
+  taskENTER_CRITICAL(&coalesce_lock);
+  evt.cb = p_cback;
+  evt.event = event;
+  memcpy(&evt.param, p_params, param_len);
+  bool was_pending = evt.pending;
+  evt.pending = true;
+  taskEXIT_CRITICAL(&coalesce_lock);
+
+  // the scheduled delivery will provide the latest value
+  if (was_pending) return true;
+
+  unsigned long elapsed = get_millis() - evt.last_ms;
+  if (elapsed >= evt.rate_limit_ms) {
+    app_coalesced_timer(idx);
+    return true;
+  }
+
+  // deliver when the rate limit has passed
+  TickType_t ticks = pdMS_TO_TICKS(evt.rate_limit_ms - elapsed);
+  if (ticks == 0) ticks = 1;
+  if (evt.timer == nullptr) {
+    evt.timer = xTimerCreate("evtTmr", ticks, pdFALSE, (void *)(intptr_t)idx,
+                             ccall_app_coalesced_timer);
+  }
+  if (evt.timer == nullptr ||
+      xTimerChangePeriod(evt.timer, ticks, 0) != pdPASS) {
+    app_coalesced_timer(idx);
+  }
+  return true;
+}
+
+void BluetoothA2DPSink::app_coalesced_timer(A2DPCoalescedEvent idx) {
+  // the message only contains the index: the value is taken from the slot
+  if (!app_work_dispatch(ccall_av_hdl_coalesced_evt, idx, nullptr, 0)) {
+    coalesced_events[idx].pending = false;
+  }
+}
+
+void BluetoothA2DPSink::av_hdl_coalesced_evt(uint16_t idx) {
+  if (idx >= A2DP_EVT_COALESCED_COUNT) return;
+  CoalescedEvent &evt = coalesced_events[idx];
+  bt_app_param_t param;
+  taskENTER_CRITICAL(&coalesce_lock);
+  app_callback_t cb = evt.cb;
+  uint16_t event = evt.event;
+  param = evt.param;
+  evt.pending = false;
+  evt.last_ms = get_millis();
+  taskEXIT_CRITICAL(&coalesce_lock);
+  if (cb != nullptr) {
+    cb(event, &param);
+  }
+}
+
+#endif
+
+// text which is provided when there is not enough memory
+static uint8_t a2dp_empty_meta_text[1] = {0};
+
+void BluetoothA2DPSink::app_next_meta_arena() {
+  // the texts of the last track stay valid until the app task released them
+  meta_arena_idx = 1 - meta_arena_idx;
+  meta_arena_used = 0;
+}
+
 void BluetoothA2DPSink::app_alloc_meta_buffer(esp_avrc_ct_cb_param_t *param) {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
   esp_avrc_ct_cb_param_t *rc = (esp_avrc_ct_cb_param_t *)(param);
-  uint8_t *attr_text = (uint8_t *)malloc(rc->meta_rsp.attr_length + 1);
+  size_t len = rc->meta_rsp.attr_length + 1;
+  uint8_t *attr_text = nullptr;
+  // use the metadata arena of the actual track if possible: an arena is only
+  // started again when the app task has released all of its texts
+  int idx = meta_arena_idx;
+  if (meta_arena_used + len <= A2DP_METADATA_ARENA_SIZE &&
+      (meta_arena_used > 0 || meta_arena_refs[idx] == 0)) {
+    attr_text = meta_arena[idx] + meta_arena_used;
+    meta_arena_used += len;
+    meta_arena_refs[idx]++;
+  } else {
+    attr_text = (uint8_t *)malloc(len);
+    if (attr_text == nullptr) {
+      ESP_LOGE(BT_AV_TAG, "%s: not enough memory", __func__);
+      rc->meta_rsp.attr_length = 0;
+      rc->meta_rsp.attr_text = a2dp_empty_meta_text;
+      return;
+    }
+  }
   memcpy(attr_text, rc->meta_rsp.attr_text, rc->meta_rsp.attr_length);
   attr_text[rc->meta_rsp.attr_length] = 0;
 
   rc->meta_rsp.attr_text = attr_text;
 }
 
+void BluetoothA2DPSink::app_free_msg(bt_app_msg_t *msg) {
+  // the metadata texts are released by the handler, which will not run
+  if (msg->cb == ccall_av_hdl_avrc_evt &&
+      msg->event == ESP_AVRC_CT_METADATA_RSP_EVT && msg->param != nullptr) {
+    esp_avrc_ct_cb_param_t *rc = (esp_avrc_ct_cb_param_t *)msg->param;
+    app_free_meta_buffer(rc->meta_rsp.attr_text);
+  }
+  BluetoothA2DPCommon::app_free_msg(msg);
+}
+
+void BluetoothA2DPSink::app_free_meta_buffer(uint8_t *attr_text) {
+  if (attr_text == a2dp_empty_meta_text) return;
+  // memory in the arena is released when all its texts have been released
+  for (int j = 0; j < 2; j++) {
+    if (attr_text >= meta_arena[j] &&
+        attr_text < meta_arena[j] + A2DP_METADATA_ARENA_SIZE) {
+      meta_arena_refs[j]--;
+      return;
+    }
+  }
+  free(attr_text);
+}
+
 void BluetoothA2DPSink::app_gap_callback(esp_bt_gap_cb_event_t event,
                                          esp_bt_gap_cb_param_t *param) {
   switch (event) {
@@ -452,11 +641,14 @@ void BluetoothA2DPSink::app_rc_ct_callback(esp_avrc_ct_cb_event_t event,
     case ESP_AVRC_CT_METADATA_RSP_EVT:
       ESP_LOGD(BT_AV_TAG, "%s ESP_AVRC_CT_METADATA_RSP_EVT", __func__);
       app_alloc_meta_buffer(param);
-      app_work_dispatch(ccall_av_hdl_avrc_evt, event, param,
-                        sizeof(esp_avrc_ct_cb_param_t));
+      if (!app_work_dispatch(ccall_av_hdl_avrc_evt, event, param,
+                             sizeof(esp_avrc_ct_cb_param_t))) {
+        app_free_meta_buffer(param->meta_rsp.attr_text);
+      }
       break;
     case ESP_AVRC_CT_CONNECTION_STATE_EVT:
       ESP_LOGD(BT_AV_TAG, "%s ESP_AVRC_CT_CONNECTION_STATE_EVT", __func__);
+      app_next_meta_arena();
       app_work_dispatch(ccall_av_hdl_avrc_evt, event, param,
                         sizeof(esp_avrc_ct_cb_param_t));
       break;
@@ -467,6 +659,23 @@ void BluetoothA2DPSink::app_rc_ct_callback(esp_avrc_ct_cb_event_t event,
       break;
     case ESP_AVRC_CT_CHANGE_NOTIFY_EVT:
       ESP_LOGD(BT_AV_TAG, "%s ESP_AVRC_CT_CHANGE_NOTIFY_EVT", __func__);
+      // the texts of the new track go into the other arena
+      if (param->change_ntf.event_id == ESP_AVRC_RN_TRACK_CHANGE) {
+        app_next_meta_arena();
+      }
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+      // only the latest play position and status is relevant
+      if (param->change_ntf.event_id == ESP_AVRC_RN_PLAY_POS_CHANGED) {
+        app_work_coalesce(A2DP_EVT_PLAY_POS, ccall_av_hdl_avrc_evt, event,
+                          param, sizeof(esp_avrc_ct_cb_param_t));
+        break;
+      }
+      if (param->change_ntf.event_id == ESP_AVRC_RN_PLAY_STATUS_CHANGE) {
+        app_work_coalesce(A2DP_EVT_PLAY_STATUS, ccall_av_hdl_avrc_evt, event,
+                          param, sizeof(esp_avrc_ct_cb_param_t));
+        break;
+      }
+#endif
       app_work_dispatch(ccall_av_hdl_avrc_evt, event, param,
                         sizeof(esp_avrc_ct_cb_param_t));
       break;
@@ -624,10 +833,67 @@ void BluetoothA2DPSink::handle_audio_cfg(uint16_t event, void *p_param) {
     if (sample_rate_callback != nullptr) {
       sample_rate_callback(m_sample_rate);
     }
+    update_output_rate();
+  }
+}
+
+void BluetoothA2DPSink::update_output_rate() {
+  if (fixed_output_rate <= 0) {
+    output_rate_set = 0;
     out->set_sample_rate(m_sample_rate);
+  } else if (output_rate_set != fixed_output_rate) {
+    // the output is only reconfigured when the fixed rate has changed
+    out->set_sample_rate(fixed_output_rate);
+    output_rate_set = fixed_output_rate;
+  }
+  // the resampler is reconfigured by the data callback, which is using it
+  is_output_rate_changed = true;
+}
+
+void BluetoothA2DPSink::apply_output_rate() {
+  is_output_rate_changed = false;
+  is_output_resampling = false;
+  if (fixed_output_rate <= 0 || m_sample_rate == fixed_output_rate) {
+    output_resampler.end();
+    return;
+  }
+  if (output_resampler.begin(m_sample_rate, fixed_output_rate,
+                             fixed_output_quality)) {
+    ESP_LOGI(BT_AV_TAG, "resampling %u -> %d", m_sample_rate,
+             fixed_output_rate);
+    is_output_resampling = true;
+  } else {
+    ESP_LOGE(BT_AV_TAG, "resampler %u -> %d failed", m_sample_rate,
+             fixed_output_rate);
   }
 }
 
+size_t BluetoothA2DPSink::write_audio_resampled(const uint8_t *data,
+                                                size_t size) {
+  size_t frames = size / 4;
+  if (output_resampler.write((const Frame *)data, frames) != frames) {
+    ESP_LOGE(BT_AV_TAG, "resampler: not enough memory");
+    return 0;
+  }
+  // make sure that we can provide all frames which are available
+  size_t max_frames =
+      (uint64_t)(frames + output_resampler.filter_taps()) * fixed_output_rate /
+          m_sample_rate + 2;
+  if (max_frames > resampled_frames_size) {
+    Frame *tmp =
+        (Frame *)realloc((void *)resampled_frames, max_frames * sizeof(Frame));
+    if (tmp == nullptr) {
+      ESP_LOGE(BT_AV_TAG, "resampler: not enough memory");
+      return 0;
+    }
+    resampled_frames = tmp;
+    resampled_frames_size = max_frames;
+  }
+  size_t result = output_resampler.read(resampled_frames, resampled_frames_size);
+  if (result == 0) return 0;
+  return write_audio((const uint8_t *)resampled_frames, result * 4);
+}
+
 void BluetoothA2DPSink::handle_avrc_connection_state(bool connected) {
   ESP_LOGD(BT_AV_TAG, "%s state %d", __func__, connected);
   avrc_connection_state = connected;
@@ -651,7 +917,10 @@ void BluetoothA2DPSink::handle_audio_state(uint16_t event, void *p_param) {
   if (!is_encoded_output()) {
     if (ESP_A2D_AUDIO_STATE_STARTED == a2d->audio_stat.state) {
       set_i2s_active(true);
+      volume_control()->fade_in();
     } else if (ESP_A2D_AUDIO_STATE_SUSPEND == a2d->audio_stat.state) {
+      // the next stream starts silent and is faded in
+      volume_control()->fade_out(true);
        // deactivate only when is_output_active_by_state is true
        if (is_output_active_by_state) set_i2s_active(false);
     }
@@ -757,6 +1026,9 @@ void BluetoothA2DPSink::handle_connection_state(uint16_t event, void *p_param) {
         reconnect_status = AutoReconnect;
       }
 
+      // the first stream is faded in
+      volume_control()->fade_out(true);
+
       // checks if the address is valid
       bool is_valid = true;
       if (address_validator != nullptr) {
@@ -935,7 +1207,7 @@ void BluetoothA2DPSink::av_hdl_avrc_evt(uint16_t event, void *p_param) {
         avrc_metadata_callback(rc->meta_rsp.attr_id, rc->meta_rsp.attr_text);
       }
 
-      free(rc->meta_rsp.attr_text);
+      app_free_meta_buffer(rc->meta_rsp.attr_text);
       break;
     }
     case ESP_AVRC_CT_CHANGE_NOTIFY_EVT: {
@@ -1150,25 +1422,53 @@ void BluetoothA2DPSink::app_a2d_callback(esp_a2d_cb_event_t event,
 void BluetoothA2DPSink::audio_data_callback(const uint8_t *data, uint32_t len) {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
 
-  // swap left and right channels
-  if (swap_left_right) {
-    Frame *frame = (Frame *)data;
-    for (int i = 0; i < len / 4; i++) {
-      int16_t temp = frame[i].channel1;
-      frame[i].channel1 = frame[i].channel2;
-      frame[i].channel2 = temp;
+  Frame *frame = (Frame *)data;
+
+  // a new source rate was reported
+  if (is_output_rate_changed) apply_output_rate();
+
+  A2DPVolumeControl *volume = volume_control();
+  bool is_fused = volume->supports_fused();
+
+  // if nobody needs to see the data we write the result directly to the output
+  if (is_output && raw_stream_reader == nullptr && stream_reader == nullptr &&
+      !is_output_resampling) {
+    uint8_t *out_data = write_audio_reserve(len);
+    if (out_data != nullptr) {
+      if (is_fused) {
+        volume->update_audio_data(frame, (Frame *)out_data, len / 4,
+                                  swap_left_right);
+      } else {
+        memcpy(out_data, data, len);
+        if (swap_left_right) swap_channels((Frame *)out_data, len / 4);
+        volume->update_audio_data((Frame *)out_data, len / 4);
+      }
+      write_audio(out_data, len);
+      if (data_received != nullptr) {
+        ESP_LOGD(BT_AV_TAG, "data_received");
+        (*data_received)();
+      }
+      return;
     }
   }
 
-  // make data available via callback, before volume control
   if (raw_stream_reader != nullptr) {
+    // swap left and right channels
+    if (swap_left_right) swap_channels(frame, len / 4);
+    // make data available via callback, before volume control
     ESP_LOGD(BT_AV_TAG, "raw_stream_reader");
     (*raw_stream_reader)(data, len);
+    // adjust the volume
+    volume->update_audio_data(frame, len / 4);
+  } else if (swap_left_right && is_fused) {
+    // swap the channels and adjust the volume in one pass
+    volume->update_audio_data(frame, frame, len / 4, true);
+  } else {
+    if (swap_left_right) swap_channels(frame, len / 4);
+    // adjust the volume
+    volume->update_audio_data(frame, len / 4);
   }
 
-  // adjust the volume
-  volume_control()->update_audio_data((Frame *)data, len / 4);
-
   // make data available via callback
   if (stream_reader != nullptr) {
     ESP_LOGD(BT_AV_TAG, "stream_reader");
@@ -1177,7 +1477,11 @@ void BluetoothA2DPSink::audio_data_callback(const uint8_t *data, uint32_t len) {
 
   // put data into ringbuffer
   if (is_output) {
-    write_audio(data, len);
+    if (is_output_resampling) {
+      write_audio_resampled(data, len);
+    } else {
+      write_audio(data, len);
+    }
   }
 
   // data_received callback
@@ -1187,6 +1491,14 @@ void BluetoothA2DPSink::audio_data_callback(const uint8_t *data, uint32_t len) {
   }
 }
 
+void BluetoothA2DPSink::swap_channels(Frame *frame, size_t frames) {
+  for (size_t i = 0; i < frames; i++) {
+    int16_t temp = frame[i].channel1;
+    frame[i].channel1 = frame[i].channel2;
+    frame[i].channel2 = temp;
+  }
+}
+
 bool BluetoothA2DPSink::is_avrc_connected() { return avrc_connection_state; }
 
 void BluetoothA2DPSink::execute_avrc_command(int cmd) {
@@ -1301,11 +1613,21 @@ size_t BluetoothA2DPSink::i2s_write_data(const uint8_t *data,
   int open = item_size;
   int processed = 0;
   while (open > 0) {
-    int written = out->write(data + processed, std::min(open, max_write_size));
+    int len = std::min(open, max_write_size);
+    // write what the output can take w/o blocking
+    int written = out->try_write(data + processed, len);
+    if (written <= 0) {
+      // the output is full
+      if (is_write_non_blocking) break;
+      delay_ms(max_write_delay_ms);
+      written = out->write(data + processed, len);
+    }
+    if (written <= 0) {
+      ESP_LOGW(BT_AV_TAG, "%s: output did not accept any data", __func__);
+      break;
+    }
     open -= written;
     processed += written;
-    // add some delay between the writes
-    delay_ms(max_write_delay_ms);
   }
   return processed;
 }
@@ -1319,10 +1641,14 @@ void BluetoothA2DPSink::app_rc_tg_callback(esp_avrc_tg_cb_event_t event,
                                            esp_avrc_tg_cb_param_t *param) {
   ESP_LOGD(BT_AV_TAG, "%s", __func__);
   switch (event) {
+    case ESP_AVRC_TG_SET_ABSOLUTE_VOLUME_CMD_EVT:
+      // only the latest volume is relevant
+      app_work_coalesce(A2DP_EVT_VOLUME, ccall_av_hdl_avrc_tg_evt, event, param,
+                        sizeof(esp_avrc_tg_cb_param_t));
+      break;
     case ESP_AVRC_TG_CONNECTION_STATE_EVT:
     case ESP_AVRC_TG_REMOTE_FEATURES_EVT:
     case ESP_AVRC_TG_PASSTHROUGH_CMD_EVT:
-    case ESP_AVRC_TG_SET_ABSOLUTE_VOLUME_CMD_EVT:
     case ESP_AVRC_TG_REGISTER_NOTIFICATION_EVT:
     case ESP_AVRC_TG_SET_PLAYER_APP_VALUE_EVT: 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
@@ -17,9 +17,12 @@
 #include "BluetoothA2DPCommon.h"
 #if IS_VALID_PLATFORM
 
+#include "A2DPResampler.h"
 #include "BluetoothA2DPOutput.h"
 #include "freertos/ringbuf.h"
 
+#include <atomic>
+
 // Comment out next line to deactivate warnings
 #ifndef A2DP_I2S_AUDIOTOOLS
 #warning "AudioTools library is not included first or installed"
@@ -48,11 +51,23 @@ extern "C" void ccall_i2s_task_handler(void* arg);
 extern "C" void ccall_audio_data_callback(const uint8_t* data, uint32_t len);
 extern "C" void ccall_av_hdl_a2d_evt(uint16_t event, void* p_param);
 extern "C" void ccall_av_hdl_avrc_evt(uint16_t event, void* p_param);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+extern "C" void ccall_av_hdl_coalesced_evt(uint16_t event, void* p_param);
+extern "C" void ccall_app_coalesced_timer(TimerHandle_t timer);
+#endif
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
 extern "C" void ccall_audio_encoded_callback(esp_a2d_conn_hdl_t conn_hdl,
                                              esp_a2d_audio_buff_t* audio_buf);
 #endif
 
+/// AVRC events for which only the latest value is delivered to the app task
+enum A2DPCoalescedEvent {
+  A2DP_EVT_PLAY_POS,
+  A2DP_EVT_PLAY_STATUS,
+  A2DP_EVT_VOLUME,
+  A2DP_EVT_COALESCED_COUNT
+};
+
 /// defines the mechanism to confirm a pin request
 enum PinCodeRequest { Undefined, Confirm, Reply };
 
@@ -112,6 +127,11 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   friend void ccall_av_hdl_a2d_evt(uint16_t event, void* p_param);
   /// avrc event handler
   friend void ccall_av_hdl_avrc_evt(uint16_t event, void* p_param);
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  /// handler for coalesced avrc events
+  friend void ccall_av_hdl_coalesced_evt(uint16_t event, void* p_param);
+  friend void ccall_app_coalesced_timer(TimerHandle_t timer);
+#endif
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
   friend void ccall_audio_encoded_callback(esp_a2d_conn_hdl_t conn_hdl,
                                            esp_a2d_audio_buff_t* audio_buf);
@@ -252,6 +272,14 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
       void (*callback)(uint8_t* id)) {
     this->avrc_rn_track_change_callback = callback;
   }
+
+  /// Play position, play status and volume events are coalesced, so that only
+  /// the latest value is delivered. In addition we can define the minimum
+  /// time in ms between 2 deliveries (default 0)
+  void set_event_rate_limit_ms(A2DPCoalescedEvent event, uint16_t ms) {
+    if (event < A2DP_EVT_COALESCED_COUNT)
+      coalesced_events[event].rate_limit_ms = ms;
+  }
 #endif
 
   /// Defines the method which will be called with the sample rate is updated
@@ -325,6 +353,20 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   /// Provides the actually set data rate (in samples per second)
   virtual uint16_t sample_rate() { return m_sample_rate; }
 
+  /// Drives the output always with the indicated sample rate (e.g. 48000):
+  /// the received audio is resampled if the source uses a different rate.
+  /// 0 (the default) switches the output to the rate of the source.
+  virtual void set_output_sample_rate(
+      int rate, A2DPResamplerQuality quality = A2DP_RESAMPLE_HIGH) {
+    fixed_output_rate = rate;
+    fixed_output_quality = quality;
+  }
+
+  /// Provides the sample rate of the output (in samples per second)
+  virtual uint32_t output_sample_rate() {
+    return fixed_output_rate > 0 ? fixed_output_rate : m_sample_rate;
+  }
+
   /// Provides the actually set number of channels (1=mono,2=stereo)
   virtual uint16_t channels() { return m_channels; }
 
@@ -413,9 +455,14 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   /// defines the max write size: default is A2DP_I2S_MAX_WRITE_SIZE
   void set_max_write_size(int size) { max_write_size = size; }
 
-  /// defines a small delay after each write: default is 0 ms
+  /// defines the delay before a blocking write, when the output can not take
+  /// any data: default is 0 ms (which just yields)
   void set_max_write_delay_ms(int delay) { max_write_delay_ms = delay; }
 
+  /// If active we never block on a full output: the data which can not be
+  /// written is dropped (default false)
+  void set_write_non_blocking(bool active) { is_write_non_blocking = active; }
+
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
   /// Provides the result of the last result for the
   /// esp_avrc_tg_get_rn_evt_cap() callback (Available from ESP_IDF_4)
@@ -440,6 +487,15 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   bool is_output = true;
   bool is_output_active_by_state = true;
   uint16_t m_sample_rate = 44100;  // set default rate
+  // optional fixed output rate: the audio is resampled to this rate
+  int fixed_output_rate = 0;
+  int output_rate_set = 0;
+  A2DPResamplerQuality fixed_output_quality = A2DP_RESAMPLE_HIGH;
+  A2DPPolyphaseResampler output_resampler;
+  volatile bool is_output_resampling = false;
+  volatile bool is_output_rate_changed = false;
+  Frame* resampled_frames = nullptr;
+  size_t resampled_frames_size = 0;
   // number of PCM channels negotiated (1=mono,2=stereo). Default 2.
   uint8_t m_channels = 2;
   uint32_t m_pkt_cnt = 0;
@@ -457,7 +513,7 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
 #endif
   _lock_t s_volume_lock;
   uint8_t s_volume = 0;
-  bool s_volume_notify;
+  bool s_volume_notify = false;
   int pin_code_int = 0;
   PinCodeRequest pin_code_request = Undefined;
   bool is_pin_code_active = false;
@@ -475,6 +531,27 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   void (*raw_stream_reader)(const uint8_t*, uint32_t) = nullptr;
   void (*avrc_connection_state_callback)(bool connected) = nullptr;
   void (*avrc_metadata_callback)(uint8_t, const uint8_t*) = nullptr;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  /// latest value of a coalesced event
+  struct CoalescedEvent {
+    app_callback_t cb;
+    uint16_t event;
+    bt_app_param_t param;
+    bool pending;
+    unsigned long last_ms;
+    uint16_t rate_limit_ms;
+    TimerHandle_t timer;
+  };
+  CoalescedEvent coalesced_events[A2DP_EVT_COALESCED_COUNT] = {};
+  portMUX_TYPE coalesce_lock = portMUX_INITIALIZER_UNLOCKED;
+  volatile bool is_coalesce_stopped = false;
+#endif
+  // metadata texts: each track change switches to the other arena, so that
+  // the texts of the last track stay valid until the app task released them
+  uint8_t meta_arena[2][A2DP_METADATA_ARENA_SIZE];
+  std::atomic<int> meta_arena_refs[2] = {{0}, {0}};
+  int meta_arena_idx = 0;
+  size_t meta_arena_used = 0;
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
   void (*avrc_rn_playstatus_callback)(esp_avrc_playback_stat_t) = nullptr;
   void (*avrc_rn_track_change_callback)(uint8_t*) = nullptr;
@@ -496,6 +573,7 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   int reconnect_delay = 1000;
   int max_write_size = A2DP_I2S_MAX_WRITE_SIZE;
   int max_write_delay_ms = A2DP_I2S_MAX_WRITE_DELAY_MS;
+  bool is_write_non_blocking = false;
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
   esp_avrc_rn_evt_cap_mask_t s_avrc_peer_rn_cap = {0};
@@ -517,7 +595,18 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   virtual int init_bluetooth();
   virtual bool app_work_dispatch(app_callback_t p_cback, uint16_t event,
                                  void* p_params, int param_len);
+  virtual A2DPEventLane app_event_lane(app_callback_t p_cback);
   virtual void app_alloc_meta_buffer(esp_avrc_ct_cb_param_t* param);
+  virtual void app_free_meta_buffer(uint8_t* attr_text);
+  void app_free_msg(bt_app_msg_t* msg) override;
+  /// the texts of a new track are stored in the other arena
+  void app_next_meta_arena();
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  virtual bool app_work_coalesce(A2DPCoalescedEvent idx, app_callback_t p_cback,
+                                 uint16_t event, void* p_params, int param_len);
+  virtual void app_coalesced_timer(A2DPCoalescedEvent idx);
+  virtual void av_hdl_coalesced_evt(uint16_t idx);
+#endif
   virtual void av_new_track();
   virtual void av_playback_changed();
   virtual void av_play_pos_changed();
@@ -549,6 +638,12 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
   virtual void handle_connection_state(uint16_t event, void* p_param);
   virtual void handle_audio_state(uint16_t event, void* p_param);
   virtual void handle_audio_cfg(uint16_t event, void* p_param);
+  /// (re)configures the output for the actual rate of the source
+  virtual void update_output_rate();
+  /// (re)configures the resampler in the data callback
+  virtual void apply_output_rate();
+  /// converts the data to the fixed output rate and writes the result
+  virtual size_t write_audio_resampled(const uint8_t* data, size_t size);
   virtual void handle_avrc_connection_state(bool connected);
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
@@ -574,6 +669,14 @@ class BluetoothA2DPSink : public BluetoothA2DPCommon {
     return i2s_write_data(data, size);
   }
 
+  /// Provides continuous memory of the requested size into which the output
+  /// can be written directly: nullptr if this is not possible. The result is
+  /// passed to write_audio(), which can then output it w/o copying.
+  virtual uint8_t* write_audio_reserve(size_t size) { return nullptr; }
+
+  /// swaps the left and the right channel in place
+  void swap_channels(Frame* frame, size_t frames);
+
   /// writes the data to i2s
   size_t i2s_write_data(const uint8_t* data, size_t item_size);
 
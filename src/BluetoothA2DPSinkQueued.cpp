@@ -5,15 +5,18 @@
 
 void BluetoothA2DPSinkQueued::bt_i2s_task_start_up(void) {
     ESP_LOGI(BT_APP_TAG, "ringbuffer data empty! mode changed: RINGBUFFER_MODE_PREFETCHING");
-    ringbuffer_mode = RINGBUFFER_MODE_PREFETCHING;
+    set_ringbuffer_mode(RINGBUFFER_MODE_PREFETCHING);
     if ((s_i2s_write_semaphore = xSemaphoreCreateBinary()) == nullptr) {
         ESP_LOGE(BT_APP_TAG, "%s, Semaphore create failed", __func__);
         return;
     }
-    if ((s_ringbuf_i2s = xRingbufferCreate(i2s_ringbuffer_size, RINGBUF_TYPE_BYTEBUF)) == nullptr) {
+    if (!ringbuffer.resize(i2s_ringbuffer_size)) {
         ESP_LOGE(BT_APP_TAG, "%s, ringbuffer create failed", __func__);
         return;
     }
+    reset_stats();
+    first_packet_ms = 0;
+    is_first_sound = true;
     //xTaskCreate(bt_i2s_task_handler, "BtI2STask", 2048, nullptr, configMAX_PRIORITIES - 3, &s_bt_i2s_task_handle);
     BaseType_t result = xTaskCreatePinnedToCore(ccall_i2s_task_handler, "BtI2STask", i2s_stack_size, nullptr, i2s_task_priority, &s_bt_i2s_task_handle, task_core);
     if (result!=pdPASS){
@@ -21,6 +24,51 @@ void BluetoothA2DPSinkQueued::bt_i2s_task_start_up(void) {
     } else {
         ESP_LOGI(BT_AV_TAG, "BtI2STask Started");
     }
+    // the output is ready before the first packet arrives
+    prepare_output();
+}
+
+void BluetoothA2DPSinkQueued::handle_audio_cfg(uint16_t event, void *p_param) {
+    BluetoothA2DPSink::handle_audio_cfg(event, p_param);
+    prepare_output();
+}
+
+void BluetoothA2DPSinkQueued::handle_audio_state(uint16_t event, void *p_param) {
+    esp_a2d_cb_param_t *a2d = (esp_a2d_cb_param_t *)(p_param);
+    if (a2d->audio_stat.state == ESP_A2D_AUDIO_STATE_SUSPEND) {
+        // measure the time to first sound of the next stream
+        first_packet_ms = 0;
+        is_first_sound = true;
+        // the next stream must not start with old audio
+        request_flush();
+    }
+    BluetoothA2DPSink::handle_audio_state(event, p_param);
+}
+
+void BluetoothA2DPSinkQueued::handle_connection_state(uint16_t event, void *p_param) {
+    esp_a2d_cb_param_t *a2d = (esp_a2d_cb_param_t *)(p_param);
+    if (a2d->conn_stat.state == ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
+        request_flush();
+    }
+    BluetoothA2DPSink::handle_connection_state(event, p_param);
+}
+
+void BluetoothA2DPSinkQueued::request_flush() {
+    is_flush_requested = true;
+    notify_consumer();
+}
+
+void BluetoothA2DPSinkQueued::prepare_output() {
+    if (!is_output || is_i2s_active || is_encoded_output()) {
+        return;
+    }
+    ESP_LOGI(BT_APP_TAG, "%s", __func__);
+    // we stay silent until the ringbuffer has been filled
+    set_i2s_active(true);
+}
+
+void BluetoothA2DPSinkQueued::record_first_packet() {
+    if (first_packet_ms == 0) first_packet_ms = get_millis();
 }
 
 void BluetoothA2DPSinkQueued::bt_i2s_task_shut_down(void) {
@@ -28,10 +76,7 @@ void BluetoothA2DPSinkQueued::bt_i2s_task_shut_down(void) {
         vTaskDelete(s_bt_i2s_task_handle);
         s_bt_i2s_task_handle = nullptr;
     }
-    if (s_ringbuf_i2s) {
-        vRingbufferDelete(s_ringbuf_i2s);
-        s_ringbuf_i2s = nullptr;
-    }
+    ringbuffer.end();
     if (s_i2s_write_semaphore) {
         vSemaphoreDelete(s_i2s_write_semaphore);
         s_i2s_write_semaphore = nullptr;
@@ -43,8 +88,6 @@ void BluetoothA2DPSinkQueued::bt_i2s_task_shut_down(void) {
 /* NEW I2S Task & ring buffer */
 
 void BluetoothA2DPSinkQueued::i2s_task_handler(void *arg) {
-    uint8_t *data = nullptr;
-    size_t item_size = 0;
     /**
      * The total length of DMA buffer of I2S is:
      * `dma_frame_num * dma_desc_num * i2s_channel_num * i2s_data_bit_width / 8`.
@@ -53,91 +96,310 @@ void BluetoothA2DPSinkQueued::i2s_task_handler(void *arg) {
     is_starting = true;
 
     while (true) {
+        // drop the audio of the last stream: the consumer releases it, so
+        // that the producer never touches the read position
+        if (is_flush_requested) {
+            is_flush_requested = false;
+            size_t available = ringbuffer.available();
+            ringbuffer.consume(available);
+            // the next stream starts with a complete prefetch
+            xSemaphoreTake(s_i2s_write_semaphore, 0);
+            set_ringbuffer_mode(RINGBUFFER_MODE_PREFETCHING);
+            is_starting = true;
+            ESP_LOGI(BT_APP_TAG, "ringbuffer flushed: %d bytes", (int)available);
+        }
+
         if (is_starting){
             // wait for ringbuffer to be filled
-            if (pdTRUE != xSemaphoreTake(s_i2s_write_semaphore, portMAX_DELAY)){
+            if (pdTRUE != xSemaphoreTake(s_i2s_write_semaphore, pdMS_TO_TICKS(i2s_ticks))){
                 continue;
             }
             is_starting = false;
         }
         // xSemaphoreTake was succeeding here, so we have the buffer filled up
-        item_size = 0;
 
-        // receive data from ringbuffer and write it to I2S DMA transmit buffer 
-        data = (uint8_t *)xRingbufferReceiveUpTo(s_ringbuf_i2s, &item_size, (TickType_t)pdMS_TO_TICKS(i2s_ticks), i2s_write_size_upto);
+        // wait up to i2s_ticks ms until the producer notifies us about new data
+        if (ringbuffer.available() == 0) {
+            is_waiting_for_data.store(true);
+            // pairs with the fence in notify_consumer(): either we see the
+            // new data or the producer sees the flag
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ringbuffer.available() == 0) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(i2s_ticks));
+            }
+            is_waiting_for_data.store(false);
+        }
+
+        // keep the start of the next stream until the output has been
+        // activated: the data of the last stream was flushed on suspend
+        if (is_output && !is_i2s_active && ringbuffer.available() < (size_t)i2s_ringbuffer_prefetch_size()) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(i2s_ticks));
+            continue;
+        }
+
+        // we write the data directly from the ringbuffer to I2S
+        A2DPRingBufferView view = ringbuffer.read_view();
+        size_t item_size = view.len[0];
+        if (item_size > i2s_write_size_upto) item_size = i2s_write_size_upto;
         if (item_size == 0) {
             if (ringbuffer_mode != RINGBUFFER_MODE_PREFETCHING) {
                 ESP_LOGI(BT_APP_TAG, "ringbuffer underflowed! mode changed: RINGBUFFER_MODE_PREFETCHING");
-                ringbuffer_mode = RINGBUFFER_MODE_PREFETCHING;
+                set_ringbuffer_mode(RINGBUFFER_MODE_PREFETCHING);
+                // wait until the (possibly increased) prefetch size is
+                // available again
+                is_starting = true;
+                underrun_count++;
+                stats.underruns++;
             }
             continue;
         } 
 
+        size_t fill = ringbuffer.available();
+        if (fill < stats.fill_min) stats.fill_min = fill;
+
         // if i2s is not active we just consume the buffer w/o output
+        size_t consumed = item_size;
         if (is_i2s_active && is_output){
-            size_t written = i2s_write_data(data, item_size);
+            int64_t start_us = esp_timer_get_time();
+            size_t written = i2s_write_data(view.data[0], item_size);
+            uint32_t duration_us = esp_timer_get_time() - start_us;
+            if (duration_us > stats.i2s_write_max_us) stats.i2s_write_max_us = duration_us;
+            stats.bytes_written += written;
+            if (is_first_sound && written > 0 && first_packet_ms != 0) {
+                stats.time_to_first_sound_ms = get_millis() - first_packet_ms;
+                is_first_sound = false;
+                ESP_LOGI(BT_APP_TAG, "time to first sound: %u ms", (unsigned)stats.time_to_first_sound_ms);
+            }
             ESP_LOGD(BT_AV_TAG, "i2s_task_handler: %d->%d", item_size, written);
             if (written==0){
-                ESP_LOGE(BT_APP_TAG, "i2s_write_data failed %d->%d", item_size, written);
+                ESP_LOGE(BT_APP_TAG, "i2s_write_data failed %d->%d", (int)item_size, (int)written);
+                // give the output some time to recover
+                delay_ms(1);
                 continue;
             }
+            // keep what the output could not take for the next write
+            consumed = written;
         }
 
-        vRingbufferReturnItem(s_ringbuf_i2s, (void *)data);
-        delay_ms(5);
+        ringbuffer.consume(consumed);
     }
 }
 
 size_t BluetoothA2DPSinkQueued::write_audio(const uint8_t *data, size_t size)
 {
-    size_t item_size = 0;
-    BaseType_t done = pdFALSE;
+    update_jitter();
+    record_first_packet();
+    stats.packets_received++;
+    stats.bytes_received += size;
 
-    // This should not really happen!
+    // The output is prepared on connection and activated by the audio state:
+    // we do not block the BT stack here
     if (!is_i2s_active){
-        ESP_LOGW(BT_APP_TAG, "i2s is not active: we try to activate it");
-        out->begin();
-        delay_ms(200);
+        ESP_LOGD(BT_APP_TAG, "i2s is not active");
     }
 
     if (ringbuffer_mode == RINGBUFFER_MODE_DROPPING) {
         ESP_LOGW(BT_APP_TAG, "ringbuffer is full, drop this packet!");
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, nullptr, &item_size);
-#else
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, &item_size);
-#endif
-        if (item_size <= i2s_ringbuffer_prefetch_size()) {
+        stats.dropped_bytes += size;
+        if (ringbuffer.available() <= (size_t)i2s_ringbuffer_prefetch_size()) {
             ESP_LOGI(BT_APP_TAG, "ringbuffer data decreased! mode changed: RINGBUFFER_MODE_PROCESSING");
-            ringbuffer_mode = RINGBUFFER_MODE_PROCESSING;
+            set_ringbuffer_mode(RINGBUFFER_MODE_PROCESSING);
         }
         return 0;
     }
 
-    done = xRingbufferSend(s_ringbuf_i2s, (void *)data, size, (TickType_t)0);
-
+    // we only write complete packets
+    int correction = drift_correction(size);
+    size_t write_size = size + correction * 4;
+    bool done = false;
+    if (reserved_data != nullptr && data == reserved_data) {
+        // the data was written in place into the memory provided by
+        // write_audio_reserve(): we just need to publish it
+        reserved_data = nullptr;
+        // repeat the last frame
+        if (correction > 0) memcpy((uint8_t *)data + size, data + size - 4, 4);
+        ringbuffer.commit(write_size);
+        done = true;
+    } else if (is_resampling) {
+        done = write_resampled(data, size);
+    } else if (ringbuffer.available_for_write() >= write_size) {
+        ringbuffer.write(data, correction < 0 ? write_size : size);
+        // repeat the last frame
+        if (correction > 0) ringbuffer.write(data + size - 4, 4);
+        done = true;
+    }
+    // only count the corrections which made it into the ringbuffer
+    if (done && correction < 0) stats.frames_dropped++;
+    if (done && correction > 0) stats.frames_repeated++;
     if (!done) {
         ESP_LOGW(BT_APP_TAG, "ringbuffer overflowed, ready to decrease data! mode changed: RINGBUFFER_MODE_DROPPING");
-        ringbuffer_mode = RINGBUFFER_MODE_DROPPING;
+        set_ringbuffer_mode(RINGBUFFER_MODE_DROPPING);
+        stats.overflows++;
+        stats.dropped_bytes += size;
     }
 
-    if (ringbuffer_mode == RINGBUFFER_MODE_PREFETCHING) {
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, nullptr, &item_size);
-#else
-        vRingbufferGetInfo(s_ringbuf_i2s, nullptr, nullptr, nullptr, &item_size);
-#endif
+    update_fill_max();
+    check_prefetch();
+    if (done) notify_consumer();
+
+    return done ? size : 0;
+}
 
-        if (item_size >= i2s_ringbuffer_prefetch_size()) {
+uint8_t *BluetoothA2DPSinkQueued::write_audio_reserve(size_t size) {
+    reserved_data = nullptr;
+    // all special cases are handled by write_audio()
+    if (!is_i2s_active || is_resampling || ringbuffer_mode == RINGBUFFER_MODE_DROPPING) {
+        return nullptr;
+    }
+    // the packet (+ 1 additional frame) must fit into the first area w/o
+    // wrapping around
+    A2DPRingBufferView view = ringbuffer.write_view();
+    if (view.len[0] < size + 4 || ((uintptr_t)view.data[0] & 3) != 0) {
+        return nullptr;
+    }
+    reserved_data = view.data[0];
+    return reserved_data;
+}
+
+int BluetoothA2DPSinkQueued::drift_correction(size_t size) {
+    if (!is_drift_correction || is_resampling || ringbuffer_mode != RINGBUFFER_MODE_PROCESSING || size < 8) {
+        return 0;
+    }
+    // keep the fill level between half of the prefetch size and half of the
+    // headroom above it
+    int target = i2s_ringbuffer_prefetch_size();
+    int fill = ringbuffer.available();
+    if (fill > target + (i2s_ringbuffer_size - target) / 2) return -1;
+    if (fill < target / 2) return 1;
+    return 0;
+}
+
+void BluetoothA2DPSinkQueued::check_prefetch() {
+    if (ringbuffer_mode == RINGBUFFER_MODE_PREFETCHING) {
+        if (ringbuffer.available() >= (size_t)i2s_ringbuffer_prefetch_size()) {
             ESP_LOGI(BT_APP_TAG, "ringbuffer data increased! mode changed: RINGBUFFER_MODE_PROCESSING");
-            ringbuffer_mode = RINGBUFFER_MODE_PROCESSING;
+            set_ringbuffer_mode(RINGBUFFER_MODE_PROCESSING);
             if (pdFALSE == xSemaphoreGive(s_i2s_write_semaphore)) {
                 ESP_LOGE(BT_APP_TAG, "semphore give failed");
             }
         }
     }
+}
 
-    return done ? size : 0;
+bool BluetoothA2DPSinkQueued::write_resampled(const uint8_t *data, size_t size) {
+    update_drift();
+    size_t frames = size / 4;
+    A2DPRingBufferView view = ringbuffer.write_view();
+    if (view.total() < resampler.max_output_frames(frames) * 4) {
+        return false;
+    }
+    // write the result directly into the (up to 2) ringbuffer areas
+    Frame *out[2] = {(Frame *)view.data[0], (Frame *)view.data[1]};
+    size_t out_len = view.len[0] / 4;
+    size_t idx = 0;
+    size_t result = resampler.resample((const Frame *)data, frames, [&](const Frame &frame) {
+        if (idx < out_len) {
+            out[0][idx] = frame;
+        } else {
+            out[1][idx - out_len] = frame;
+        }
+        idx++;
+    });
+    ringbuffer.commit(result * 4);
+    return true;
+}
+
+void BluetoothA2DPSinkQueued::update_drift() {
+    // PI controller which keeps the (smoothed) fill level at the prefetch size
+    int target = i2s_ringbuffer_prefetch_size();
+    if (target <= 0 || ringbuffer_mode != RINGBUFFER_MODE_PROCESSING) return;
+    drift_fill += ((float)ringbuffer.available() - drift_fill) / 32.0f;
+    float error = (drift_fill - target) / target;
+    drift_integral += error * drift_ki;
+    if (drift_integral > drift_max) drift_integral = drift_max;
+    if (drift_integral < -drift_max) drift_integral = -drift_max;
+    float correction = error * drift_kp + drift_integral;
+    if (correction > drift_max) correction = drift_max;
+    if (correction < -drift_max) correction = -drift_max;
+    // more input frames per output frame if the buffer is too full
+    resampler.set_factor(1.0f + correction);
+}
+
+void BluetoothA2DPSinkQueued::update_jitter() {
+    if (ringbuffer_latency_ms <= 0) return;
+    unsigned long now = get_millis();
+
+    // estimate the packet inter-arrival time and its mean deviation
+    int interval = now - jitter_last_ms;
+    if (jitter_last_ms != 0 && interval < 1000) {
+        int err = interval * 16 - jitter_mean;
+        jitter_mean += err / 8;
+        jitter_dev += ((err < 0 ? -err : err) - jitter_dev) / 4;
+    }
+    jitter_last_ms = now;
+    int needed_ms = (jitter_mean + 4 * jitter_dev) / 16;
+    int max_ms = i2s_ringbuffer_max_latency_ms();
+
+    if (underrun_count != jitter_underrun_count) {
+        // grow after an underrun
+        jitter_underrun_count = underrun_count;
+        int latency = jitter_latency_ms + jitter_latency_ms / 4;
+        if (latency < needed_ms) latency = needed_ms;
+        jitter_latency_ms = latency < max_ms ? latency : max_ms;
+        jitter_stable_ms = now;
+        ESP_LOGI(BT_APP_TAG, "jitter buffer latency increased to %d ms", jitter_latency_ms);
+    } else if (now - jitter_stable_ms > A2DP_JITTER_STABLE_MS) {
+        // shrink slowly when the link is stable
+        int min_ms = ringbuffer_latency_ms > needed_ms ? ringbuffer_latency_ms : needed_ms;
+        int latency = jitter_latency_ms - jitter_latency_ms / 10;
+        if (latency < min_ms) latency = min_ms;
+        if (latency < jitter_latency_ms) jitter_latency_ms = latency;
+        jitter_stable_ms = now;
+        ESP_LOGD(BT_APP_TAG, "jitter buffer latency %d ms", jitter_latency_ms);
+    }
+}
+
+void BluetoothA2DPSinkQueued::notify_consumer() {
+    // wake up the I2S task if it is waiting for data: the fence orders the
+    // commit of the data before the check of the flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (is_waiting_for_data.load() && s_bt_i2s_task_handle != nullptr) {
+        xTaskNotifyGive(s_bt_i2s_task_handle);
+    }
+}
+
+void BluetoothA2DPSinkQueued::update_fill_max() {
+    size_t fill = ringbuffer.available();
+    if (fill > stats.fill_max) stats.fill_max = fill;
+}
+
+void BluetoothA2DPSinkQueued::set_ringbuffer_mode(A2DPRingBufferMode mode) {
+    unsigned long now = get_millis();
+    taskENTER_CRITICAL(&stats_lock);
+    stats.mode_time_ms[ringbuffer_mode] += now - mode_start_ms;
+    mode_start_ms = now;
+    ringbuffer_mode = mode;
+    taskEXIT_CRITICAL(&stats_lock);
+}
+
+A2DPSinkQueuedStats BluetoothA2DPSinkQueued::get_stats() {
+    unsigned long now = get_millis();
+    taskENTER_CRITICAL(&stats_lock);
+    A2DPSinkQueuedStats result = stats;
+    // add the time of the actual mode
+    result.mode_time_ms[ringbuffer_mode] += now - mode_start_ms;
+    taskEXIT_CRITICAL(&stats_lock);
+    return result;
+}
+
+void BluetoothA2DPSinkQueued::reset_stats() {
+    unsigned long now = get_millis();
+    taskENTER_CRITICAL(&stats_lock);
+    stats = A2DPSinkQueuedStats();
+    // the minimum is only known after the first output
+    stats.fill_max = ringbuffer.available();
+    mode_start_ms = now;
+    taskEXIT_CRITICAL(&stats_lock);
 }
 
 #endif // platform
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "BluetoothA2DPSink.h"
+#include "A2DPRingBuffer.h"
+#include "A2DPResampler.h"
+
+#include <atomic>
 
 #if IS_VALID_PLATFORM
 
@@ -16,6 +20,41 @@ enum A2DPRingBufferMode : char {
                               audio data, I2S is working */
 };
 
+/**
+ * @brief Statistics of the audio pipeline of BluetoothA2DPSinkQueued
+ * @ingroup a2dp
+ */
+struct A2DPSinkQueuedStats {
+  /// number of audio packets received from the source
+  uint32_t packets_received = 0;
+  /// number of bytes received from the source
+  uint32_t bytes_received = 0;
+  /// number of bytes written to the output
+  uint32_t bytes_written = 0;
+  /// number of times the ringbuffer was running empty
+  uint32_t underruns = 0;
+  /// number of times the ringbuffer was full and we started to drop packets
+  uint32_t overflows = 0;
+  /// number of bytes which were dropped
+  uint32_t dropped_bytes = 0;
+  /// single frames removed by the drift correction
+  uint32_t frames_dropped = 0;
+  /// single frames repeated by the drift correction
+  uint32_t frames_repeated = 0;
+  /// time in ms spent in each A2DPRingBufferMode
+  uint32_t mode_time_ms[3] = {0, 0, 0};
+  /// minimum fill level of the ringbuffer in bytes: UINT32_MAX as long as
+  /// no data has been output
+  uint32_t fill_min = UINT32_MAX;
+  /// maximum fill level of the ringbuffer in bytes
+  uint32_t fill_max = 0;
+  /// longest duration of a single i2s_write_data() call in us
+  uint32_t i2s_write_max_us = 0;
+  /// time in ms from the first received packet of the last stream until its
+  /// audio was written to the output
+  uint32_t time_to_first_sound_ms = 0;
+};
+
 /**
  * @brief BluetoothA2DPSinkQueued provides an A2DP sink implementation with a
  * queued, task-based I2S output to address the volume delay and jitter issues
@@ -79,8 +118,9 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
   /// Defines the stack size of the i2s task (in bytes)
   void set_i2s_stack_size(int size) { i2s_stack_size = size; }
 
-  /// Defines the ringbuffer size used by the i2s task (in bytes)
-  void set_i2s_ringbuffer_size(int size) { i2s_ringbuffer_size = size; }
+  /// Defines the ringbuffer size used by the i2s task (in bytes): it is
+  /// rounded down to complete frames
+  void set_i2s_ringbuffer_size(int size) { i2s_ringbuffer_size = size / 4 * 4; }
 
   /// Audio starts to play when limit exeeded
   void set_i2s_ringbuffer_prefetch_percent(int percent) {
@@ -89,6 +129,43 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
     ringbuffer_prefetch_percent = percent;
   }
 
+  /// Activates the adaptive jitter buffer: instead of the prefetch percent
+  /// the audio starts when the buffered data covers the target latency (in
+  /// ms). The latency is increased after an underrun when the measured packet
+  /// jitter requires it and it is reduced slowly again when the link is stable.
+  void set_i2s_ringbuffer_latency_ms(int ms) {
+    ringbuffer_latency_ms = ms;
+    jitter_latency_ms = ms;
+  }
+
+  /// Provides the actual latency of the adaptive jitter buffer in ms
+  int i2s_ringbuffer_latency_ms() { return jitter_latency_ms; }
+
+  /// Keeps the fill level of the ringbuffer around the prefetch size by
+  /// removing or repeating single frames (default false). Otherwise we only
+  /// drop complete packets when the ringbuffer is full.
+  void set_i2s_drift_correction(bool active) { is_drift_correction = active; }
+
+  /// Compensates the clock drift between the source and the I2S output with
+  /// a fractional resampler (default false). The resampling factor is
+  /// determined from the fill level of the ringbuffer. If active, this
+  /// replaces the drift correction by single frames. This must be called
+  /// before start(): the resampler is used by the BT data callback.
+  void set_i2s_resampling(bool active) {
+    is_resampling = active;
+    drift_integral = 0.0f;
+    resampler.reset();
+  }
+
+  /// Provides the actual resampling factor (input frames per output frame)
+  float i2s_resampling_factor() { return resampler.factor(); }
+
+  /// Provides a copy of the actual statistics
+  A2DPSinkQueuedStats get_stats();
+
+  /// Resets the statistics
+  void reset_stats();
+
   /// Defines the priority of the I2S task
   void set_i2s_task_priority(UBaseType_t prio) { i2s_task_priority = prio; }
 
@@ -98,7 +175,7 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
 
  protected:
   TaskHandle_t s_bt_i2s_task_handle = nullptr; /* handle of I2S task */
-  RingbufHandle_t s_ringbuf_i2s = nullptr; /* handle of ringbuffer for I2S */
+  A2DPRingBuffer ringbuffer; /* ringbuffer for I2S */
   SemaphoreHandle_t s_i2s_write_semaphore = nullptr;
   // I2S task
   int i2s_stack_size = 2048;
@@ -106,27 +183,86 @@ class BluetoothA2DPSinkQueued : public BluetoothA2DPSink {
   UBaseType_t i2s_task_priority = configMAX_PRIORITIES - 3;
   volatile A2DPRingBufferMode ringbuffer_mode = RINGBUFFER_MODE_PROCESSING;
   volatile bool is_starting = true;
+  std::atomic<bool> is_waiting_for_data{false};
+  volatile bool is_flush_requested = false;
   size_t i2s_write_size_upto = 240 * 6;
   int i2s_ticks = 20;
   int ringbuffer_prefetch_percent = RINGBUF_PREFETCH_PERCENT;
+  // adaptive jitter buffer
+  int ringbuffer_latency_ms = 0;
+  int jitter_latency_ms = 0;
+  int jitter_mean = 0;  // inter-arrival time in 1/16 ms
+  int jitter_dev = 0;   // mean deviation in 1/16 ms
+  unsigned long jitter_last_ms = 0;
+  unsigned long jitter_stable_ms = 0;
+  uint32_t jitter_underrun_count = 0;
+  volatile uint32_t underrun_count = 0;
+  // statistics
+  A2DPSinkQueuedStats stats;
+  unsigned long mode_start_ms = 0;
+  portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+  // drift correction
+  bool is_drift_correction = false;
+  uint8_t* reserved_data = nullptr;
+  // time to first sound
+  unsigned long first_packet_ms = 0;
+  volatile bool is_first_sound = false;
+  // clock drift compensation
+  bool is_resampling = false;
+  A2DPLinearResampler resampler;
+  float drift_fill = 0.0f;
+  float drift_integral = 0.0f;
+  float drift_kp = 0.001f;
+  float drift_ki = 0.000001f;
+  float drift_max = 0.005f;
 
   void bt_i2s_task_start_up(void) override;
   void bt_i2s_task_shut_down(void) override;
   void i2s_task_handler(void* arg) override;
+  void handle_audio_cfg(uint16_t event, void* p_param) override;
+  void handle_audio_state(uint16_t event, void* p_param) override;
+  void handle_connection_state(uint16_t event, void* p_param) override;
+  /// the I2S task drops all buffered data
+  void request_flush();
+  void prepare_output();
+  void record_first_packet();
   size_t write_audio(const uint8_t* data, size_t size) override;
+  uint8_t* write_audio_reserve(size_t size) override;
+  void check_prefetch();
+  void update_jitter();
+  void set_ringbuffer_mode(A2DPRingBufferMode mode);
+  void update_fill_max();
+  void notify_consumer();
+  int drift_correction(size_t size);
+  void update_drift();
+  bool write_resampled(const uint8_t* data, size_t size);
 
   void set_i2s_active(bool active) override {
     BluetoothA2DPSink::set_i2s_active(active);
     if (active) {
-      ringbuffer_mode = RINGBUFFER_MODE_PREFETCHING;
+      // a give w/o waiting consumer must not skip the next prefetch
+      if (s_i2s_write_semaphore != nullptr) {
+        xSemaphoreTake(s_i2s_write_semaphore, 0);
+      }
+      set_ringbuffer_mode(RINGBUFFER_MODE_PREFETCHING);
       is_starting = true;
     }
   }
 
   int i2s_ringbuffer_prefetch_size() {
     int bytes = i2s_ringbuffer_size * ringbuffer_prefetch_percent / 100;
+    if (ringbuffer_latency_ms > 0) {
+      int max_ms = i2s_ringbuffer_max_latency_ms();
+      int ms = jitter_latency_ms < max_ms ? jitter_latency_ms : max_ms;
+      bytes = (int64_t)ms * output_sample_rate() / 1000 * 4;
+    }
     return (bytes / 4 * 4);
   }
+
+  /// max latency in ms which is supported by the ringbuffer
+  int i2s_ringbuffer_max_latency_ms() {
+    return (int64_t)i2s_ringbuffer_size * 90 / 100 * 1000 / 4 / output_sample_rate();
+  }
 };
 
 #endif  // platform
@@ -57,6 +57,11 @@ extern "C" int32_t ccall_bt_app_a2d_data_cb(uint8_t *data, int32_t len) {
   return 0;
 }
 
+extern "C" void ccall_prefill_task_handler(void *arg) {
+  if (actual_bluetooth_a2dp_source)
+    actual_bluetooth_a2dp_source->prefill_task_handler(arg);
+}
+
 BluetoothA2DPSource::BluetoothA2DPSource() {
   ESP_LOGD(BT_APP_TAG, "%s, ", __func__);
   actual_bluetooth_a2dp_source = this;
@@ -155,6 +160,9 @@ void BluetoothA2DPSource::start(std::vector<const char *> names) {
   /* create application task */
   app_task_start_up();
 
+  /* fill the buffer before we are connected */
+  prefill_task_start_up();
+
   /* Bluetooth device name, connection mode and profile set up */
   bt_app_work_dispatch(ccall_av_hdl_stack_evt, BT_APP_EVT_STACK_UP, nullptr, 0,
                        nullptr);
@@ -183,22 +191,157 @@ void BluetoothA2DPSource::end(bool release_memory) {
   
   // standard end
   BluetoothA2DPCommon::end(release_memory);
+
+  prefill_task_shut_down();
 }
 
 int32_t BluetoothA2DPSource::get_audio_data_volume(uint8_t *data, int32_t len) {
-  int32_t result = get_audio_data(data, len);
-  volume_control()->update_audio_data(data, len);
+  int32_t result = prefill_buffer ? get_prefill_data(data, len)
+                                  : get_audio_data(data, len);
+  // the encoder needs most of the CPU: skip the volume at unity gain and only
+  // process the frames which were provided
+  if (result > 0 && !volume_control()->is_unity()) {
+    int32_t bytes = (result + 3) / 4 * 4;
+    volume_control()->update_audio_data(data, bytes < len ? bytes : len);
+  }
   return result;
 }
 
+int32_t BluetoothA2DPSource::get_prefill_data(uint8_t *data, int32_t len) {
+  // drop the audio which was buffered before the stream started: only the
+  // consumer may release it
+  if (is_prefill_flush_requested) {
+    is_prefill_flush_requested = false;
+    prefill_buffer.consume(prefill_buffer.available());
+    is_prefill_starting = true;
+  }
+  // send silence until the buffer is half full again
+  if (is_prefill_starting) {
+    if (prefill_buffer.available() < prefill_buffer.size() / 2) {
+      memset(data, 0, len);
+      if (prefill_task_handle != nullptr) xTaskNotifyGive(prefill_task_handle);
+      return len;
+    }
+    is_prefill_starting = false;
+  }
+
+  size_t result = prefill_buffer.read(data, len);
+  if (result < (size_t)len) {
+    // send silence
+    memset(data + result, 0, len - result);
+    prefill_underruns++;
+    prefill_underrun_bytes += len - result;
+  }
+  // the producer can continue
+  if (result > 0 && prefill_task_handle != nullptr) {
+    xTaskNotifyGive(prefill_task_handle);
+  }
+  return len;
+}
+
+void BluetoothA2DPSource::prefill_task_start_up() {
+  if (prefill_ms <= 0 || prefill_task_handle != nullptr) return;
+  size_t size = (size_t)prefill_ms * A2DP_SOURCE_SAMPLE_RATE / 1000 * 4;
+  if (!prefill_buffer.resize(size)) {
+    ESP_LOGE(BT_APP_TAG, "%s, ringbuffer create failed", __func__);
+    return;
+  }
+  prefill_underruns = 0;
+  prefill_underrun_bytes = 0;
+  is_prefill_running = true;
+  if (xTaskCreatePinnedToCore(ccall_prefill_task_handler, "BtPrefillT",
+                              prefill_stack_size, nullptr,
+                              prefill_task_priority, &prefill_task_handle,
+                              task_core) != pdPASS) {
+    ESP_LOGE(BT_APP_TAG, "%s failed", __func__);
+    is_prefill_running = false;
+    prefill_buffer.end();
+  }
+}
+
+void BluetoothA2DPSource::prefill_task_shut_down() {
+  if (prefill_task_handle == nullptr) return;
+  // let the task finish the actual request of the data callback
+  is_prefill_running = false;
+  xTaskNotifyGive(prefill_task_handle);
+  for (int j = 0; j < 100 && prefill_task_handle != nullptr; j++) {
+    delay_ms(10);
+  }
+  if (prefill_task_handle != nullptr) {
+    vTaskDelete(prefill_task_handle);
+    prefill_task_handle = nullptr;
+  }
+  prefill_buffer.end();
+}
+
+void BluetoothA2DPSource::prefill_task_handler(void *arg) {
+  ESP_LOGI(BT_APP_TAG, "%s", __func__);
+  while (is_prefill_running) {
+    // request the data directly into the ringbuffer
+    A2DPRingBufferView view = prefill_buffer.write_view();
+    size_t chunk = A2DP_SOURCE_PREFILL_CHUNK_SIZE;
+    if (chunk > prefill_buffer.size() / 2) chunk = prefill_buffer.size() / 2;
+    if (view.total() < chunk || view.len[0] == 0) {
+      // wait until the BT stack has consumed some data
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+      continue;
+    }
+    // at the end of the buffer we might get less than a chunk
+    size_t len = view.len[0] < chunk ? view.len[0] : chunk;
+    int32_t result = get_audio_data(view.data[0], len);
+    if (result > 0) {
+      prefill_buffer.commit(result);
+    } else {
+      // no data available
+      delay_ms(5);
+    }
+  }
+  prefill_task_handle = nullptr;
+  vTaskDelete(nullptr);
+}
+
 
 int32_t BluetoothA2DPSource::get_audio_data(uint8_t *data, int32_t len) {
+  if (data_resampler) {
+    return get_audio_data_resampled(data, len);
+  }
+  return get_audio_data_input(data, len);
+}
+
+int32_t BluetoothA2DPSource::get_audio_data_resampled(uint8_t *data,
+                                                      int32_t len) {
+  size_t frames = len / 4;
+  size_t needed = data_resampler.input_frames(frames);
+  if (needed > 0) {
+    // the input is written directly into the buffer of the resampler
+    Frame *area = data_resampler.input_area(needed);
+    if (area == nullptr) return 0;
+    // the bytes of an incomplete frame from the last call come first
+    uint8_t *area_data = (uint8_t *)area;
+    int32_t available = resample_remainder_len;
+    memcpy(area_data, resample_remainder, available);
+    int32_t result =
+        get_audio_data_input(area_data + available, needed * 4 - available);
+    if (result > 0) available += result;
+    // keep the bytes which do not fill a frame for the next call
+    resample_remainder_len = available % 4;
+    memcpy(resample_remainder, area_data + available - resample_remainder_len,
+           resample_remainder_len);
+    data_resampler.commit_input(available / 4);
+  }
+  return data_resampler.read((Frame *)data, frames) * 4;
+}
+
+int32_t BluetoothA2DPSource::get_audio_data_input(uint8_t *data, int32_t len) {
   if (get_data_cb != nullptr) {
     return get_data_cb(data, len);
   }
   if (get_data_in_frames_cb != nullptr) {
     return 4 * get_data_in_frames_cb((Frame *)data, len / 4);
   }
+  if (get_data_typed_cb != nullptr) {
+    return get_audio_data_typed(data, len);
+  }
 #ifdef ARDUINO
   if (p_stream != nullptr) {
     int32_t result = p_stream->readBytes(data, len);
@@ -217,6 +360,104 @@ int32_t BluetoothA2DPSource::get_audio_data(uint8_t *data, int32_t len) {
   return 0;
 }
 
+/// converts a sample to 16 bits
+static inline int16_t a2dp_to_int16(int16_t value, int shift) { return value; }
+
+static inline int16_t a2dp_to_int16(int32_t value, int shift) {
+  return value >> shift;
+}
+
+static inline int16_t a2dp_to_int16(float value, int shift) {
+  float result = value * 32767.0f;
+  return result < -32768.0f ? -32768 : (result > 32767.0f ? 32767 : result);
+}
+
+/// converts the samples in place to 16 bit stereo frames
+template <typename T>
+static void a2dp_convert_frames(uint8_t *data, int32_t frames, int channels,
+                                int shift) {
+  const T *in = (const T *)data;
+  Frame *out = (Frame *)data;
+  if (channels == 2) {
+    // the output is never bigger than the input
+    for (int32_t i = 0; i < frames; i++) {
+      int16_t left = a2dp_to_int16(in[i * 2], shift);
+      int16_t right = a2dp_to_int16(in[i * 2 + 1], shift);
+      out[i].channel1 = left;
+      out[i].channel2 = right;
+    }
+  } else if (sizeof(T) < sizeof(Frame)) {
+    // the output is bigger than the input: we start at the end
+    for (int32_t i = frames - 1; i >= 0; i--) {
+      int16_t value = a2dp_to_int16(in[i], shift);
+      out[i].channel1 = value;
+      out[i].channel2 = value;
+    }
+  } else {
+    for (int32_t i = 0; i < frames; i++) {
+      int16_t value = a2dp_to_int16(in[i], shift);
+      out[i].channel1 = value;
+      out[i].channel2 = value;
+    }
+  }
+}
+
+int32_t BluetoothA2DPSource::get_audio_data_typed(uint8_t *data, int32_t len) {
+  int sample_size = typed_format == A2DP_SAMPLE_INT16 ? 2 : 4;
+  int frame_size = sample_size * typed_channels;
+  int32_t frames = len / 4;
+  int32_t done = 0;
+  // if the input frames are bigger than the output we need to fill the
+  // remaining part of the buffer with additional requests
+  while (done < frames) {
+    // the input must fit into the buffer and the converted output as well
+    // (e.g. 16 bit mono frames are expanded to twice their size)
+    int32_t open = (frames - done) * 4 / frame_size;
+    if (open > frames - done) open = frames - done;
+    if (open == 0) break;
+    int32_t result = read_frames_typed(data + done * 4, open);
+    if (result <= 0) break;
+    done += result;
+    if (result < open) break;
+  }
+  return done * 4;
+}
+
+int32_t BluetoothA2DPSource::read_frames_typed(uint8_t *data, int32_t frames) {
+  int32_t result = 0;
+  switch (typed_format) {
+    case A2DP_SAMPLE_INT16:
+      result = ((music_data_int16_cb_t)get_data_typed_cb)((int16_t *)data,
+                                                          frames);
+      if (result > frames) result = frames;
+      // stereo 16 bit data is already in the right format
+      if (typed_channels == 1 && result > 0) {
+        a2dp_convert_frames<int16_t>(data, result, 1, 0);
+      }
+      break;
+    case A2DP_SAMPLE_INT24_IN_32:
+    case A2DP_SAMPLE_INT32:
+      result = ((music_data_int32_cb_t)get_data_typed_cb)((int32_t *)data,
+                                                          frames);
+      if (result > frames) result = frames;
+      if (result > 0) {
+        a2dp_convert_frames<int32_t>(
+            data, result, typed_channels,
+            typed_format == A2DP_SAMPLE_INT32 ? 16 : 8);
+      }
+      break;
+    case A2DP_SAMPLE_FLOAT:
+      result = ((music_data_float_cb_t)get_data_typed_cb)((float *)data,
+                                                          frames);
+      if (result > frames) result = frames;
+      if (result > 0) {
+        a2dp_convert_frames<float>(data, result, typed_channels, 0);
+      }
+      break;
+  }
+  return result;
+}
+
 void BluetoothA2DPSource::reset_last_connection() {
   ESP_LOGI(BT_APP_TAG, "%s, ", __func__);
   [[maybe_unused]] const char *bda_str = to_str(last_connection);
@@ -240,24 +481,34 @@ bool BluetoothA2DPSource::bt_app_work_dispatch(bt_app_cb_t p_cback,
 
   msg.sig = BT_APP_SIG_WORK_DISPATCH;
   msg.event = event;
+  msg.lane = app_event_lane(p_cback);
   msg.cb = p_cback;
 
   if (param_len == 0) {
     return app_send_msg(&msg);
   } else if (p_params && param_len > 0) {
-    if ((msg.param = malloc(param_len)) != nullptr) {
+    if ((msg.param = app_msg_pool.alloc(param_len)) != nullptr) {
       memcpy(msg.param, p_params, param_len);
       /* check if caller has provided a copy callback to do the deep copy */
       if (p_copy_cback) {
         p_copy_cback(&msg, msg.param, p_params);
       }
-      return app_send_msg(&msg);
+      if (app_send_msg(&msg)) return true;
+      app_msg_pool.free(msg.param);
     }
   }
 
   return false;
 }
 
+A2DPEventLane BluetoothA2DPSource::app_event_lane(bt_app_cb_t p_cback) {
+  // AVRC events must not delay the connection and media state changes
+  if (p_cback == ccall_bt_av_hdl_avrc_ct_evt) return A2DP_LANE_INFO;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
+  if (p_cback == ccall_av_hdl_avrc_tg_evt) return A2DP_LANE_INFO;
+#endif
+  return A2DP_LANE_CONTROL;
+}
 
 bool BluetoothA2DPSource::get_name_from_eir(uint8_t *eir, uint8_t *bdname,
                                             uint8_t *bdname_len) {
@@ -793,6 +1044,8 @@ void BluetoothA2DPSource::bt_app_av_state_connected_hdlr(uint16_t event,
       a2d = (esp_a2d_cb_param_t *)(param);
       if (ESP_A2D_AUDIO_STATE_STARTED == a2d->audio_stat.state) {
         s_pkt_cnt = 0;
+        // the stream must not start with stale audio
+        if (prefill_buffer) is_prefill_flush_requested = true;
       }
       break;
     }
@@ -22,6 +22,8 @@
 #include <vector>
 
 #include "BluetoothA2DPCommon.h"
+#include "A2DPRingBuffer.h"
+#include "A2DPResampler.h"
 
 #if IS_VALID_PLATFORM
 
@@ -37,6 +39,22 @@
 
 typedef int32_t (*music_data_cb_t)(uint8_t* data, int32_t len);
 typedef int32_t (*music_data_frames_cb_t)(Frame* data, int32_t len);
+typedef int32_t (*music_data_int16_cb_t)(int16_t* data, int32_t frames);
+typedef int32_t (*music_data_int32_cb_t)(int32_t* data, int32_t frames);
+typedef int32_t (*music_data_float_cb_t)(float* data, int32_t frames);
+
+/**
+ * @brief Sample formats which are supported by the typed data callbacks of
+ * BluetoothA2DPSource
+ * @ingroup a2dp
+ */
+enum A2DPSampleFormat {
+  A2DP_SAMPLE_INT16,       ///< 16 bit
+  A2DP_SAMPLE_INT24_IN_32, ///< 24 bit in the lower bytes of a 32 bit value,
+                           ///< sign extended to 32 bits
+  A2DP_SAMPLE_INT32,       ///< 32 bit (or 24 bit in the upper bytes)
+  A2DP_SAMPLE_FLOAT,       ///< float in the range of -1.0 to 1.0
+};
 typedef void (*bt_app_copy_cb_t)(bt_app_msg_t* msg, void* p_dest, void* p_src);
 typedef void (*bt_app_cb_t)(uint16_t event, void* param);
 
@@ -44,6 +62,7 @@ extern "C" void ccall_a2d_app_heart_beat(TIMER_ARG_TYPE arg);
 extern "C" void ccall_bt_app_av_sm_hdlr(uint16_t event, void* param);
 extern "C" void ccall_bt_av_hdl_avrc_ct_evt(uint16_t event, void* param);
 extern "C" int32_t ccall_bt_app_a2d_data_cb(uint8_t* data, int32_t len);
+extern "C" void ccall_prefill_task_handler(void* arg);
 
 /**
  * @brief Buetooth A2DP global state
@@ -101,6 +120,7 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   friend void ccall_bt_app_av_sm_hdlr(uint16_t event, void* param);
   friend void ccall_bt_av_hdl_avrc_ct_evt(uint16_t event, void* param);
   friend int32_t ccall_bt_app_a2d_data_cb(uint8_t* data, int32_t len);
+  friend void ccall_prefill_task_handler(void* arg);
 
  public:
   /// Constructor
@@ -135,14 +155,67 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   /// Defines the data callback
   virtual void set_data_callback(int32_t(cb)(uint8_t* data, int32_t len)) {
     get_data_cb = cb;
+    if (cb != nullptr) get_data_typed_cb = nullptr;
   }
 
   /// Defines the data callback
   virtual void set_data_callback_in_frames(int32_t(cb)(Frame* data,
                                                        int32_t len)) {
     get_data_in_frames_cb = cb;
+    if (cb != nullptr) get_data_typed_cb = nullptr;
+  }
+
+  /// Defines a data callback which provides 16 bit samples with 1 or 2
+  /// channels: the callback gets the max number of frames and returns the
+  /// number of provided frames. The data is converted in place in the buffer
+  /// of the encoder.
+  virtual void set_data_callback_int16(music_data_int16_cb_t cb,
+                                       int channels = 2) {
+    set_data_callback_typed((void*)cb, A2DP_SAMPLE_INT16, channels);
+  }
+
+  /// Defines a data callback which provides 32 bit samples with 1 or 2
+  /// channels. Use is24Bits if the 24 bit values are stored in the lower 3
+  /// bytes: they must be sign extended to the full 32 bit value.
+  virtual void set_data_callback_int32(music_data_int32_cb_t cb,
+                                       int channels = 2,
+                                       bool is24Bits = false) {
+    set_data_callback_typed(
+        (void*)cb, is24Bits ? A2DP_SAMPLE_INT24_IN_32 : A2DP_SAMPLE_INT32,
+        channels);
   }
 
+  /// Defines a data callback which provides float samples with 1 or 2
+  /// channels
+  virtual void set_data_callback_float(music_data_float_cb_t cb,
+                                       int channels = 2) {
+    set_data_callback_typed((void*)cb, A2DP_SAMPLE_FLOAT, channels);
+  }
+
+  /// Defines the sample rate of the data which is provided by the data
+  /// callbacks or streams: if it is different from 44100 the data is
+  /// converted with a polyphase resampler. The quality defines the number of
+  /// filter taps and therefore the CPU load. Must be called before start():
+  /// the call is refused while the resampler might be in use.
+  virtual bool set_data_sample_rate(
+      int rate, A2DPResamplerQuality quality = A2DP_RESAMPLE_MEDIUM) {
+    if (is_connected() || prefill_task_handle != nullptr) {
+      ESP_LOGE(BT_AV_TAG, "%s: not possible while the data is requested",
+               __func__);
+      return false;
+    }
+    data_sample_rate = rate;
+    resample_remainder_len = 0;
+    if (rate == A2DP_SOURCE_SAMPLE_RATE) {
+      data_resampler.end();
+      return true;
+    }
+    return data_resampler.begin(rate, A2DP_SOURCE_SAMPLE_RATE, quality);
+  }
+
+  /// Provides the sample rate of the data
+  int get_data_sample_rate() { return data_sample_rate; }
+
 #ifdef ARDUINO
 
   /// Defines a single Arduino Stream (e.g. File) as audio source
@@ -153,6 +226,34 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   }
 #endif
 
+  /// Decouples the data callbacks from the BT stack: a separate task fills a
+  /// ringbuffer which covers the indicated time in ms and the BT stack only
+  /// copies the data from there. If not enough data is available we send
+  /// silence. 0 (the default) calls the data callbacks directly. The buffer
+  /// is flushed when a stream starts, and the output waits until it is half
+  /// full again. Must be called before start().
+  virtual void set_prefill_buffer_ms(int ms) { prefill_ms = ms; }
+
+  /// Defines the priority of the prefill task
+  void set_prefill_task_priority(UBaseType_t prio) {
+    prefill_task_priority = prio;
+  }
+
+  /// Defines the stack size of the prefill task (in bytes)
+  void set_prefill_stack_size(int size) { prefill_stack_size = size; }
+
+  /// Number of data requests of the BT stack which could not be served
+  /// completely from the prefill buffer
+  uint32_t get_prefill_underruns() { return prefill_underruns; }
+
+  /// Number of bytes of silence which were sent because of underruns
+  uint32_t get_prefill_underrun_bytes() { return prefill_underrun_bytes; }
+
+  /// Actual fill level of the prefill buffer in ms
+  int get_prefill_level_ms() {
+    return prefill_buffer.available() / 4 * 1000 / A2DP_SOURCE_SAMPLE_RATE;
+  }
+
   /// Starts the A2DP source w/o indicating any names: use the ssid callback to
   /// select the device
   virtual void start() {
@@ -265,6 +366,14 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   /// callback for data
   int32_t (*get_data_cb)(uint8_t* data, int32_t len) = nullptr;
   int32_t (*get_data_in_frames_cb)(Frame* data, int32_t len) = nullptr;
+  void* get_data_typed_cb = nullptr;
+  A2DPSampleFormat typed_format = A2DP_SAMPLE_INT16;
+  int typed_channels = 2;
+  int data_sample_rate = A2DP_SOURCE_SAMPLE_RATE;
+  A2DPPolyphaseResampler data_resampler;
+  /// bytes of an incomplete frame which are kept for the next resampler input
+  uint8_t resample_remainder[4];
+  int resample_remainder_len = 0;
 #ifdef ARDUINO
   Stream* p_stream = nullptr;
   Stream& (*get_next_stream_cb)() = nullptr;
@@ -283,7 +392,7 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   int s_intv_cnt = 0;
   int s_connecting_heatbeat_count;
   uint32_t s_pkt_cnt;
-  TimerHandle_t s_tmr;
+  TimerHandle_t s_tmr = nullptr;
 
   // initialization
   bool reset_ble = false;
@@ -303,6 +412,17 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   int reconnect_retries = 0;
   int max_reconnect_retries = 0;
   unsigned long last_heart_beat = 0;
+  // prefill task
+  int prefill_ms = 0;
+  int prefill_stack_size = 4096;
+  UBaseType_t prefill_task_priority = configMAX_PRIORITIES - 3;
+  TaskHandle_t prefill_task_handle = nullptr;
+  A2DPRingBuffer prefill_buffer;
+  volatile bool is_prefill_running = false;
+  volatile bool is_prefill_flush_requested = false;
+  bool is_prefill_starting = false;
+  volatile uint32_t prefill_underruns = 0;
+  volatile uint32_t prefill_underrun_bytes = 0;
 
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 0, 0)
   esp_avrc_rn_evt_cap_mask_t s_avrc_peer_rn_cap;
@@ -320,12 +440,39 @@ class BluetoothA2DPSource : public BluetoothA2DPCommon {
   virtual int32_t get_audio_data(uint8_t* data, int32_t len);
   /// provides the audio after applying the volume
   virtual int32_t get_audio_data_volume(uint8_t* data, int32_t len);
+  /// provides the audio from the data callbacks or streams
+  virtual int32_t get_audio_data_input(uint8_t* data, int32_t len);
+  /// provides the audio converted to 44100 samples per second
+  virtual int32_t get_audio_data_resampled(uint8_t* data, int32_t len);
+  /// provides the audio from the typed data callback
+  virtual int32_t get_audio_data_typed(uint8_t* data, int32_t len);
+  /// requests the frames from the typed data callback and converts them in
+  /// place to 16 bit stereo frames
+  virtual int32_t read_frames_typed(uint8_t* data, int32_t frames);
+  void set_data_callback_typed(void* cb, A2DPSampleFormat format,
+                               int channels) {
+    typed_format = format;
+    typed_channels = channels == 1 ? 1 : 2;
+    get_data_typed_cb = cb;
+    // the last defined callback is used
+    if (cb != nullptr) {
+      get_data_cb = nullptr;
+      get_data_in_frames_cb = nullptr;
+    }
+  }
+  /// provides the audio from the prefill buffer: fills up with silence
+  virtual int32_t get_prefill_data(uint8_t* data, int32_t len);
+
+  virtual void prefill_task_start_up();
+  virtual void prefill_task_shut_down();
+  virtual void prefill_task_handler(void* arg);
 
   virtual void process_user_state_callbacks(uint16_t event, void* param);
 
   virtual bool bt_app_work_dispatch(bt_app_cb_t p_cback, uint16_t event,
                                     void* p_params, int param_len,
                                     bt_app_copy_cb_t p_copy_cback);
+  virtual A2DPEventLane app_event_lane(bt_app_cb_t p_cback);
   virtual void bt_app_av_media_proc(uint16_t event, void* param);
 
   /// A2DP application state machine handler for each state
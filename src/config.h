@@ -34,3 +34,38 @@
 #ifndef A2DP_DISCONNECT_LIMIT 
 #  define A2DP_DISCONNECT_LIMIT 20
 #endif
+
+// Time in ms w/o underrun after which the adaptive jitter buffer is reduced
+#ifndef A2DP_JITTER_STABLE_MS
+#  define A2DP_JITTER_STABLE_MS 10000
+#endif
+
+// Memory in bytes for the metadata texts of a track: 2 arenas are reserved
+#ifndef A2DP_METADATA_ARENA_SIZE
+#  define A2DP_METADATA_ARENA_SIZE 512
+#endif
+
+// Number of event types for which the app task latency is recorded
+#ifndef A2DP_EVENT_LATENCY_TYPES
+#  define A2DP_EVENT_LATENCY_TYPES 24
+#endif
+
+// Number of log2 (ms) buckets of the app task latency histogram
+#ifndef A2DP_EVENT_LATENCY_BUCKETS
+#  define A2DP_EVENT_LATENCY_BUCKETS 12
+#endif
+
+// Length in frames of the gain ramps of the volume control (0 = no ramps)
+#ifndef A2DP_VOLUME_RAMP_FRAMES
+#  define A2DP_VOLUME_RAMP_FRAMES 256
+#endif
+
+// Sample rate of the audio which is sent by the source
+#ifndef A2DP_SOURCE_SAMPLE_RATE
+#  define A2DP_SOURCE_SAMPLE_RATE 44100
+#endif
+
+// Max number of bytes which are requested at once by the source prefill task
+#ifndef A2DP_SOURCE_PREFILL_CHUNK_SIZE
+#  define A2DP_SOURCE_PREFILL_CHUNK_SIZE 512
+#endif
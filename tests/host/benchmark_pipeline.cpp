@@ -0,0 +1,212 @@
+// Host version of examples/bt_music_receiver_benchmark: we push synthetic
+// stereo PCM packets with the real A2DP sizes through the real sink and
+// source classes (the Bluetooth stack is replaced by the stubs) and report
+// the time in ns/frame and the share of the real time budget.
+
+#include <math.h>
+
+#include <atomic>
+#include <chrono>
+
+#include "BluetoothA2DPSinkQueued.h"
+#include "BluetoothA2DPSource.h"
+#include "host_test.h"
+
+const int sizes[] = {512, 4096};
+const int rates[] = {44100, 48000};
+const int iterations = 2000;
+
+Frame pcm_ref[1024];
+Frame pcm[1024];
+uint8_t encoder_data[4096];
+size_t source_pos = 0;
+
+/// Output which accepts all data and counts the bytes
+class CountingOutput : public BluetoothA2DPOutput {
+ public:
+  bool begin() override { return true; }
+  size_t write(const uint8_t *data, size_t len) override {
+    bytes += len;
+    return len;
+  }
+  void end() override {}
+  void set_sample_rate(int rate) override {}
+  void set_output_active(bool active) override {}
+  std::atomic<size_t> bytes{0};
+};
+
+/// Sink which receives the data w/o Bluetooth stack
+class HostSink : public BluetoothA2DPSink {
+ public:
+  HostSink(BluetoothA2DPOutput &out) : BluetoothA2DPSink(out) {
+    set_i2s_active(true);
+  }
+  using BluetoothA2DPSink::audio_data_callback;
+  using BluetoothA2DPSink::update_output_rate;
+};
+
+/// Queued sink which receives the data w/o Bluetooth stack: the I2S task is
+/// running while the object exists
+class HostSinkQueued : public BluetoothA2DPSinkQueued {
+ public:
+  HostSinkQueued(BluetoothA2DPOutput &out, bool resampling) {
+    set_output(out);
+    set_i2s_resampling(resampling);
+    bt_i2s_task_start_up();
+  }
+  ~HostSinkQueued() { bt_i2s_task_shut_down(); }
+  using BluetoothA2DPSinkQueued::audio_data_callback;
+
+  /// the producer is waiting for the I2S task like the BT stack, which
+  /// provides the data in real time
+  void wait_for_space(size_t size) {
+    while (ringbuffer.available_for_write() < 2 * size) vTaskDelay(0);
+  }
+
+  /// waits until the I2S task has consumed everything it can
+  size_t buffered() {
+    size_t result = ringbuffer.available();
+    for (int j = 0; j < 100; j++) {
+      vTaskDelay(1);
+      size_t actual = ringbuffer.available();
+      if (actual == result) break;
+      result = actual;
+    }
+    return result;
+  }
+};
+
+/// Source which provides the data for the encoder w/o Bluetooth stack
+class HostSource : public BluetoothA2DPSource {
+ public:
+  using BluetoothA2DPSource::get_audio_data_volume;
+};
+
+int32_t get_frames(Frame *data, int32_t len) {
+  for (int j = 0; j < len; j++) {
+    data[j] = pcm_ref[source_pos++ % 1024];
+  }
+  return len;
+}
+
+int32_t get_mono(int16_t *data, int32_t frames) {
+  for (int j = 0; j < frames; j++) {
+    data[j] = pcm_ref[source_pos++ % 1024].channel1;
+  }
+  return frames;
+}
+
+template <typename Stage>
+double measure_ns(int frames, Stage stage) {
+  return measure_ns(frames, stage, [](int frames) {});
+}
+
+/// Only the time of the stage is measured: prepare() is called before
+template <typename Stage, typename Prepare>
+double measure_ns(int frames, Stage stage, Prepare prepare) {
+  std::chrono::steady_clock::duration total{0};
+  for (int j = 0; j < iterations; j++) {
+    memcpy((void *)pcm, pcm_ref, frames * sizeof(Frame));
+    prepare(frames);
+    auto start = std::chrono::steady_clock::now();
+    stage(frames);
+    total += std::chrono::steady_clock::now() - start;
+  }
+  return std::chrono::duration<double, std::nano>(total).count() /
+         iterations / frames;
+}
+
+void report(const char *name, int size, double ns) {
+  int frames = size / 4;
+  printf("%-22s %5d bytes %8.2f ns/frame", name, size, ns);
+  for (int rate : rates) {
+    double budget_ns = 1000000000.0 / rate;
+    printf("  %6.3f%% @ %d", ns * 100 / budget_ns, rate);
+  }
+  printf("\n");
+  CHECK(ns * frames < 1000000000.0 * frames / 48000);
+}
+
+void benchmark_sink(const char *name, int size, bool swap, bool mono,
+                    int output_rate) {
+  CountingOutput out;
+  HostSink sink(out);
+  sink.set_volume(100);
+  sink.set_swap_lr_channels(swap);
+  sink.set_mono_downmix(mono);
+  if (output_rate > 0) {
+    sink.set_output_sample_rate(output_rate);
+    sink.update_output_rate();
+  }
+  report(name, size, measure_ns(size / 4, [&](int frames) {
+           sink.audio_data_callback((uint8_t *)pcm, frames * 4);
+         }));
+  CHECK(out.bytes > 0);
+  if (output_rate == 0) CHECK(out.bytes == (size_t)size * iterations);
+}
+
+void benchmark_sink_queued(const char *name, int size, bool resampling) {
+  CountingOutput out;
+  HostSinkQueued sink(out, resampling);
+  sink.set_volume(100);
+  report(name, size,
+         measure_ns(
+             size / 4,
+             [&](int frames) {
+               sink.audio_data_callback((uint8_t *)pcm, frames * 4);
+             },
+             [&](int frames) { sink.wait_for_space(frames * 4); }));
+  A2DPSinkQueuedStats stats = sink.get_stats();
+  CHECK(stats.packets_received == (uint32_t)iterations);
+  CHECK(stats.overflows == 0);
+  // the I2S task has output everything which is not kept for the prefetch
+  size_t buffered = sink.buffered();
+  CHECK(out.bytes > 0);
+  if (!resampling) CHECK(out.bytes + buffered == (size_t)size * iterations);
+}
+
+void benchmark_source(const char *name, int size, int volume, bool mono,
+                      int data_rate) {
+  HostSource source;
+  if (mono) {
+    source.set_data_callback_int16(get_mono, 1);
+  } else {
+    source.set_data_callback_in_frames(get_frames);
+  }
+  if (data_rate != A2DP_SOURCE_SAMPLE_RATE) {
+    CHECK(source.set_data_sample_rate(data_rate));
+  }
+  source.set_volume(volume);
+  int32_t provided = 0;
+  report(name, size, measure_ns(size / 4, [&](int frames) {
+           provided += source.get_audio_data_volume(encoder_data, frames * 4);
+         }));
+  CHECK(provided > 0);
+  if (data_rate == A2DP_SOURCE_SAMPLE_RATE) {
+    CHECK(provided == size * iterations);
+  }
+}
+
+int main() {
+  // synthetic decoded SBC output: 1 kHz sine on both channels
+  for (int j = 0; j < 1024; j++) {
+    int16_t value = 16000 * sin(2.0 * M_PI * 1000.0 * j / 44100.0);
+    pcm_ref[j] = Frame(value, -value);
+  }
+
+  for (int size : sizes) {
+    benchmark_sink("sink", size, false, false, 0);
+    benchmark_sink("sink swap", size, true, false, 0);
+    benchmark_sink("sink mono downmix", size, false, true, 0);
+    benchmark_sink("sink resample 48000", size, false, false, 48000);
+    benchmark_sink_queued("queued sink", size, false);
+    benchmark_sink_queued("queued sink drift", size, true);
+    benchmark_source("source", size, 127, false, A2DP_SOURCE_SAMPLE_RATE);
+    benchmark_source("source volume", size, 64, false,
+                     A2DP_SOURCE_SAMPLE_RATE);
+    benchmark_source("source int16 mono", size, 127, true,
+                     A2DP_SOURCE_SAMPLE_RATE);
+    benchmark_source("source resample 48000", size, 127, false, 48000);
+  }
+  return TEST_RESULT();
+}
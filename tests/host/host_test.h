@@ -0,0 +1,20 @@
+#pragma once
+// Minimal check macros for the host tests: the failed checks are reported
+// and the test fails if there was any failure
+
+#include <stdio.h>
+
+static int host_test_failures = 0;
+
+#define CHECK(cond)                                                     \
+  do {                                                                  \
+    if (!(cond)) {                                                      \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, \
+              #cond);                                                   \
+      host_test_failures++;                                             \
+    }                                                                   \
+  } while (0)
+
+#define TEST_RESULT()                                            \
+  (printf("%s\n", host_test_failures == 0 ? "OK" : "FAILED"), \
+   host_test_failures == 0 ? 0 : 1)
@@ -0,0 +1,144 @@
+#pragma once
+// Host replacement of the ESP-IDF A2DP API: the audio data callbacks are
+// registered, but the data needs to be provided by the test
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+  ESP_A2D_CONNECTION_STATE_DISCONNECTED,
+  ESP_A2D_CONNECTION_STATE_CONNECTING,
+  ESP_A2D_CONNECTION_STATE_CONNECTED,
+  ESP_A2D_CONNECTION_STATE_DISCONNECTING
+} esp_a2d_connection_state_t;
+
+typedef enum {
+  ESP_A2D_AUDIO_STATE_SUSPEND,
+  ESP_A2D_AUDIO_STATE_STARTED,
+  // deprecated names
+  ESP_A2D_AUDIO_STATE_REMOTE_SUSPEND = ESP_A2D_AUDIO_STATE_SUSPEND,
+  ESP_A2D_AUDIO_STATE_STOPPED = ESP_A2D_AUDIO_STATE_SUSPEND
+} esp_a2d_audio_state_t;
+
+typedef enum {
+  ESP_A2D_DISC_RSN_NORMAL,
+  ESP_A2D_DISC_RSN_ABNORMAL
+} esp_a2d_disc_rsn_t;
+
+typedef enum {
+  ESP_A2D_CONNECTION_STATE_EVT,
+  ESP_A2D_AUDIO_STATE_EVT,
+  ESP_A2D_AUDIO_CFG_EVT,
+  ESP_A2D_MEDIA_CTRL_ACK_EVT,
+  ESP_A2D_PROF_STATE_EVT,
+  ESP_A2D_REPORT_SNK_DELAY_VALUE_EVT
+} esp_a2d_cb_event_t;
+
+typedef uint8_t esp_a2d_mct_t;
+#define ESP_A2D_MCT_SBC 0
+#define ESP_A2D_MCT_M12 1
+#define ESP_A2D_MCT_M24 2
+#define ESP_A2D_MCT_ATRAC 4
+
+#define ESP_A2D_SBC_CIE_SF_48K 1
+#define ESP_A2D_SBC_CIE_SF_44K 2
+#define ESP_A2D_SBC_CIE_SF_32K 4
+#define ESP_A2D_SBC_CIE_CH_MODE_JOINT_STEREO 1
+#define ESP_A2D_SBC_CIE_CH_MODE_STEREO 2
+#define ESP_A2D_SBC_CIE_CH_MODE_MONO 8
+#define ESP_A2D_SBC_CIE_BLOCK_LEN_16 1
+#define ESP_A2D_SBC_CIE_ALLOC_MTHD_SNR 2
+#define ESP_A2D_SBC_CIE_ALLOC_MTHD_LOUDNESS 1
+#define ESP_A2D_SBC_CIE_NUM_SUBBANDS_8 1
+
+typedef struct {
+  esp_a2d_mct_t type;
+  union {
+    struct {
+      uint8_t samp_freq;
+      uint8_t ch_mode;
+      uint8_t block_len;
+      uint8_t alloc_mthd;
+      uint8_t num_subbands;
+      uint8_t min_bitpool;
+      uint8_t max_bitpool;
+    } sbc_info;
+    uint8_t sbc[4];
+  } cie;
+} esp_a2d_mcc_t;
+
+typedef enum {
+  ESP_A2D_MEDIA_CTRL_NONE,
+  ESP_A2D_MEDIA_CTRL_CHECK_SRC_RDY,
+  ESP_A2D_MEDIA_CTRL_START,
+  ESP_A2D_MEDIA_CTRL_SUSPEND
+} esp_a2d_media_ctrl_t;
+
+typedef enum {
+  ESP_A2D_MEDIA_CTRL_ACK_SUCCESS,
+  ESP_A2D_MEDIA_CTRL_ACK_FAILURE,
+  ESP_A2D_MEDIA_CTRL_ACK_BUSY
+} esp_a2d_media_ctrl_ack_t;
+
+typedef enum {
+  ESP_A2D_DEINIT_SUCCESS,
+  ESP_A2D_INIT_SUCCESS
+} esp_a2d_init_state_t;
+
+typedef union {
+  struct {
+    esp_a2d_connection_state_t state;
+    esp_bd_addr_t remote_bda;
+    esp_a2d_disc_rsn_t disc_rsn;
+  } conn_stat;
+  struct {
+    esp_a2d_audio_state_t state;
+    esp_bd_addr_t remote_bda;
+  } audio_stat;
+  struct {
+    esp_bd_addr_t remote_bda;
+    esp_a2d_mcc_t mcc;
+  } audio_cfg;
+  struct {
+    esp_a2d_media_ctrl_t cmd;
+    esp_a2d_media_ctrl_ack_t status;
+  } media_ctrl_stat;
+  struct {
+    esp_a2d_init_state_t init_state;
+  } a2d_prof_stat;
+  struct {
+    uint16_t delay_value;
+  } a2d_report_delay_value_stat;
+} esp_a2d_cb_param_t;
+
+typedef uint16_t esp_a2d_conn_hdl_t;
+
+typedef struct {
+  uint8_t *data;
+  uint16_t data_len;
+} esp_a2d_audio_buff_t;
+
+typedef void (*esp_a2d_cb_t)(esp_a2d_cb_event_t event,
+                             esp_a2d_cb_param_t *param);
+typedef void (*esp_a2d_sink_data_cb_t)(const uint8_t *buf, uint32_t len);
+typedef void (*esp_a2d_sink_audio_data_cb_t)(esp_a2d_conn_hdl_t conn_hdl,
+                                             esp_a2d_audio_buff_t *audio_buf);
+typedef int32_t (*esp_a2d_source_data_cb_t)(uint8_t *buf, int32_t len);
+
+esp_err_t esp_a2d_register_callback(esp_a2d_cb_t callback);
+esp_err_t esp_a2d_sink_init();
+esp_err_t esp_a2d_sink_deinit();
+esp_err_t esp_a2d_sink_connect(esp_bd_addr_t remote_bda);
+esp_err_t esp_a2d_sink_disconnect(esp_bd_addr_t remote_bda);
+esp_err_t esp_a2d_sink_register_data_callback(esp_a2d_sink_data_cb_t callback);
+esp_err_t esp_a2d_sink_register_audio_data_callback(
+    esp_a2d_sink_audio_data_cb_t callback);
+esp_err_t esp_a2d_sink_register_stream_endpoint(uint8_t seid,
+                                                const esp_a2d_mcc_t *mcc);
+void esp_a2d_audio_buff_free(esp_a2d_audio_buff_t *audio_buf);
+esp_err_t esp_a2d_source_init();
+esp_err_t esp_a2d_source_deinit();
+esp_err_t esp_a2d_source_connect(esp_bd_addr_t remote_bda);
+esp_err_t esp_a2d_source_disconnect(esp_bd_addr_t remote_bda);
+esp_err_t esp_a2d_source_register_data_callback(
+    esp_a2d_source_data_cb_t callback);
+esp_err_t esp_a2d_media_ctrl(esp_a2d_media_ctrl_t ctrl);
@@ -0,0 +1,216 @@
+#pragma once
+// Host replacement of the ESP-IDF AVRCP API
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+  ESP_AVRC_CT_CONNECTION_STATE_EVT,
+  ESP_AVRC_CT_PASSTHROUGH_RSP_EVT,
+  ESP_AVRC_CT_METADATA_RSP_EVT,
+  ESP_AVRC_CT_PLAY_STATUS_RSP_EVT,
+  ESP_AVRC_CT_CHANGE_NOTIFY_EVT,
+  ESP_AVRC_CT_REMOTE_FEATURES_EVT,
+  ESP_AVRC_CT_GET_RN_CAPABILITIES_RSP_EVT,
+  ESP_AVRC_CT_SET_ABSOLUTE_VOLUME_RSP_EVT,
+  ESP_AVRC_CT_PROF_STATE_EVT
+} esp_avrc_ct_cb_event_t;
+
+typedef enum {
+  ESP_AVRC_TG_CONNECTION_STATE_EVT,
+  ESP_AVRC_TG_REMOTE_FEATURES_EVT,
+  ESP_AVRC_TG_PASSTHROUGH_CMD_EVT,
+  ESP_AVRC_TG_SET_ABSOLUTE_VOLUME_CMD_EVT,
+  ESP_AVRC_TG_REGISTER_NOTIFICATION_EVT,
+  ESP_AVRC_TG_SET_PLAYER_APP_VALUE_EVT,
+  ESP_AVRC_TG_PROF_STATE_EVT
+} esp_avrc_tg_cb_event_t;
+
+typedef enum {
+  ESP_AVRC_PLAYBACK_STOPPED,
+  ESP_AVRC_PLAYBACK_PLAYING,
+  ESP_AVRC_PLAYBACK_PAUSED,
+  ESP_AVRC_PLAYBACK_FWD_SEEK,
+  ESP_AVRC_PLAYBACK_REV_SEEK,
+  ESP_AVRC_PLAYBACK_ERROR = 0xff
+} esp_avrc_playback_stat_t;
+
+typedef enum {
+  ESP_AVRC_RN_PLAY_STATUS_CHANGE = 0x01,
+  ESP_AVRC_RN_TRACK_CHANGE,
+  ESP_AVRC_RN_TRACK_REACHED_END,
+  ESP_AVRC_RN_TRACK_REACHED_START,
+  ESP_AVRC_RN_PLAY_POS_CHANGED,
+  ESP_AVRC_RN_BATTERY_STATUS_CHANGE,
+  ESP_AVRC_RN_SYSTEM_STATUS_CHANGE,
+  ESP_AVRC_RN_APP_SETTING_CHANGE,
+  ESP_AVRC_RN_NOW_PLAYING_CHANGE,
+  ESP_AVRC_RN_AVAILABLE_PLAYERS_CHANGE,
+  ESP_AVRC_RN_ADDRESSED_PLAYER_CHANGE,
+  ESP_AVRC_RN_UIDS_CHANGE,
+  ESP_AVRC_RN_VOLUME_CHANGE
+} esp_avrc_rn_event_ids_t;
+
+typedef enum {
+  ESP_AVRC_RN_RSP_INTERIM = 13,
+  ESP_AVRC_RN_RSP_CHANGED = 15
+} esp_avrc_rn_rsp_t;
+
+typedef enum {
+  ESP_AVRC_MD_ATTR_TITLE = 0x1,
+  ESP_AVRC_MD_ATTR_ARTIST = 0x2,
+  ESP_AVRC_MD_ATTR_ALBUM = 0x4,
+  ESP_AVRC_MD_ATTR_TRACK_NUM = 0x8,
+  ESP_AVRC_MD_ATTR_NUM_TRACKS = 0x10,
+  ESP_AVRC_MD_ATTR_GENRE = 0x20,
+  ESP_AVRC_MD_ATTR_PLAYING_TIME = 0x40
+} esp_avrc_md_attr_mask_t;
+
+typedef enum {
+  ESP_AVRC_PT_CMD_PLAY = 0x44,
+  ESP_AVRC_PT_CMD_STOP = 0x45,
+  ESP_AVRC_PT_CMD_PAUSE = 0x46,
+  ESP_AVRC_PT_CMD_REWIND = 0x48,
+  ESP_AVRC_PT_CMD_FAST_FORWARD = 0x49,
+  ESP_AVRC_PT_CMD_FORWARD = 0x4b,
+  ESP_AVRC_PT_CMD_BACKWARD = 0x4c,
+  ESP_AVRC_PT_CMD_VOL_UP = 0x41,
+  ESP_AVRC_PT_CMD_VOL_DOWN = 0x42
+} esp_avrc_pt_cmd_t;
+
+typedef enum {
+  ESP_AVRC_PT_CMD_STATE_PRESSED,
+  ESP_AVRC_PT_CMD_STATE_RELEASED
+} esp_avrc_pt_cmd_state_t;
+
+typedef enum {
+  ESP_AVRC_INIT_SUCCESS,
+  ESP_AVRC_DEINIT_SUCCESS
+} esp_avrc_init_state_t;
+
+typedef enum {
+  ESP_AVRC_BIT_MASK_OP_TEST,
+  ESP_AVRC_BIT_MASK_OP_SET,
+  ESP_AVRC_BIT_MASK_OP_CLEAR
+} esp_avrc_bit_mask_op_t;
+
+typedef enum {
+  ESP_AVRC_PSTH_FILTER_ALLOWED_CMD,
+  ESP_AVRC_PSTH_FILTER_SUPPORTED_CMD
+} esp_avrc_psth_filter_t;
+
+typedef enum { ESP_AVRC_RN_CAP_ALLOWED_EVT, ESP_AVRC_RN_CAP_SUPPORTED_EVT } esp_avrc_rn_cap_t;
+
+typedef struct {
+  uint16_t bits;
+} esp_avrc_rn_evt_cap_mask_t;
+
+typedef struct {
+  uint16_t bits[8];
+} esp_avrc_psth_bit_mask_t;
+
+typedef union {
+  uint8_t volume;
+  esp_avrc_playback_stat_t playback;
+  uint8_t elm_id[8];
+  uint32_t play_pos;
+} esp_avrc_rn_param_t;
+
+typedef union {
+  struct {
+    bool connected;
+    esp_bd_addr_t remote_bda;
+  } conn_stat;
+  struct {
+    uint8_t tl;
+    uint8_t key_code;
+    uint8_t key_state;
+    uint8_t rsp_code;
+  } psth_rsp;
+  struct {
+    uint8_t attr_id;
+    uint8_t *attr_text;
+    int attr_length;
+  } meta_rsp;
+  struct {
+    uint8_t event_id;
+    esp_avrc_rn_param_t event_parameter;
+  } change_ntf;
+  struct {
+    uint32_t feat_mask;
+    uint16_t tg_feat_flag;
+    esp_bd_addr_t remote_bda;
+  } rmt_feats;
+  struct {
+    uint8_t cap_count;
+    esp_avrc_rn_evt_cap_mask_t evt_set;
+  } get_rn_caps_rsp;
+  struct {
+    uint8_t volume;
+  } set_volume_rsp;
+  struct {
+    esp_avrc_init_state_t state;
+  } avrc_ct_init_stat;
+} esp_avrc_ct_cb_param_t;
+
+typedef union {
+  struct {
+    bool connected;
+    esp_bd_addr_t remote_bda;
+  } conn_stat;
+  struct {
+    uint32_t feat_mask;
+    uint16_t ct_feat_flag;
+    esp_bd_addr_t remote_bda;
+  } rmt_feats;
+  struct {
+    uint8_t key_code;
+    uint8_t key_state;
+  } psth_cmd;
+  struct {
+    uint8_t volume;
+  } set_abs_vol;
+  struct {
+    uint8_t event_id;
+    uint32_t event_parameter;
+  } reg_ntf;
+  struct {
+    uint8_t num_val;
+    void *p_vals;
+  } set_app_value;
+  struct {
+    esp_avrc_init_state_t state;
+  } avrc_tg_init_stat;
+} esp_avrc_tg_cb_param_t;
+
+typedef void (*esp_avrc_ct_cb_t)(esp_avrc_ct_cb_event_t event,
+                                 esp_avrc_ct_cb_param_t *param);
+typedef void (*esp_avrc_tg_cb_t)(esp_avrc_tg_cb_event_t event,
+                                 esp_avrc_tg_cb_param_t *param);
+
+esp_err_t esp_avrc_ct_register_callback(esp_avrc_ct_cb_t callback);
+esp_err_t esp_avrc_ct_init();
+esp_err_t esp_avrc_ct_deinit();
+esp_err_t esp_avrc_ct_send_get_rn_capabilities_cmd(uint8_t tl);
+esp_err_t esp_avrc_ct_send_metadata_cmd(uint8_t tl, uint8_t attr_mask);
+esp_err_t esp_avrc_ct_send_passthrough_cmd(uint8_t tl, uint8_t key_code,
+                                           uint8_t key_state);
+esp_err_t esp_avrc_ct_send_register_notification_cmd(uint8_t tl,
+                                                     uint8_t event_id,
+                                                     uint32_t event_parameter);
+esp_err_t esp_avrc_ct_send_set_absolute_volume_cmd(uint8_t tl, uint8_t volume);
+esp_err_t esp_avrc_tg_register_callback(esp_avrc_tg_cb_t callback);
+esp_err_t esp_avrc_tg_init();
+esp_err_t esp_avrc_tg_deinit();
+esp_err_t esp_avrc_tg_get_psth_cmd_filter(esp_avrc_psth_filter_t filter,
+                                          esp_avrc_psth_bit_mask_t *cmd_set);
+esp_err_t esp_avrc_tg_set_psth_cmd_filter(
+    esp_avrc_psth_filter_t filter, const esp_avrc_psth_bit_mask_t *cmd_set);
+esp_err_t esp_avrc_tg_get_rn_evt_cap(esp_avrc_rn_cap_t cap,
+                                     esp_avrc_rn_evt_cap_mask_t *evt_set);
+esp_err_t esp_avrc_tg_set_rn_evt_cap(const esp_avrc_rn_evt_cap_mask_t *evt_set);
+esp_err_t esp_avrc_tg_send_rn_rsp(esp_avrc_rn_event_ids_t event_id,
+                                  esp_avrc_rn_rsp_t rsp,
+                                  esp_avrc_rn_param_t *param);
+bool esp_avrc_rn_evt_bit_mask_operation(esp_avrc_bit_mask_op_t op,
+                                        esp_avrc_rn_evt_cap_mask_t *events,
+                                        esp_avrc_rn_event_ids_t event_id);
@@ -0,0 +1,32 @@
+#pragma once
+// Host replacement of the ESP-IDF Bluetooth controller API: there is no
+// controller, so all calls just succeed
+
+#include "esp_bt_defs.h"
+#include "esp_system.h"
+
+typedef enum {
+  ESP_BT_MODE_IDLE = 0,
+  ESP_BT_MODE_BLE = 1,
+  ESP_BT_MODE_CLASSIC_BT = 2,
+  ESP_BT_MODE_BTDM = 3
+} esp_bt_mode_t;
+
+typedef enum {
+  ESP_BT_CONTROLLER_STATUS_IDLE,
+  ESP_BT_CONTROLLER_STATUS_INITED,
+  ESP_BT_CONTROLLER_STATUS_ENABLED
+} esp_bt_controller_status_t;
+
+typedef struct {
+  int mode;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() {0}
+
+esp_bt_controller_status_t esp_bt_controller_get_status();
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg);
+esp_err_t esp_bt_controller_deinit();
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+esp_err_t esp_bt_controller_disable();
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode);
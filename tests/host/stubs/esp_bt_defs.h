@@ -0,0 +1,12 @@
+#pragma once
+// Host replacement of the common Bluetooth definitions of the ESP-IDF
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#define ESP_BD_ADDR_LEN 6
+typedef uint8_t esp_bd_addr_t[ESP_BD_ADDR_LEN];
+
+typedef enum { ESP_BT_STATUS_SUCCESS, ESP_BT_STATUS_FAIL } esp_bt_status_t;
@@ -0,0 +1,5 @@
+#pragma once
+// Host replacement of the ESP-IDF Bluetooth device API: nothing is used by
+// the library
+
+#include "esp_bt_defs.h"
@@ -0,0 +1,211 @@
+// Host implementation of the ESP-IDF Bluetooth, AVRCP and NVS API: there is
+// no Bluetooth stack on the host, so the calls just succeed and the tests
+// feed the audio data directly into the library
+
+#include "esp_a2dp_api.h"
+#include "esp_avrc_api.h"
+#include "esp_bt.h"
+#include "esp_bt_main.h"
+#include "esp_gap_bt_api.h"
+#include "esp_spp_api.h"
+#include "nvs_flash.h"
+
+// controller
+
+esp_bt_controller_status_t esp_bt_controller_get_status() {
+  return ESP_BT_CONTROLLER_STATUS_IDLE;
+}
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_controller_deinit() { return ESP_OK; }
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode) { return ESP_OK; }
+esp_err_t esp_bt_controller_disable() { return ESP_OK; }
+esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode) { return ESP_OK; }
+
+// bluedroid
+
+esp_bluedroid_status_t esp_bluedroid_get_status() {
+  return ESP_BLUEDROID_STATUS_UNINITIALIZED;
+}
+esp_err_t esp_bluedroid_init() { return ESP_OK; }
+esp_err_t esp_bluedroid_init_with_cfg(esp_bluedroid_config_t *cfg) {
+  return ESP_OK;
+}
+esp_err_t esp_bluedroid_deinit() { return ESP_OK; }
+esp_err_t esp_bluedroid_enable() { return ESP_OK; }
+esp_err_t esp_bluedroid_disable() { return ESP_OK; }
+
+// gap
+
+esp_err_t esp_bt_gap_register_callback(esp_bt_gap_cb_t callback) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_set_scan_mode(esp_bt_connection_mode_t c_mode,
+                                   esp_bt_discovery_mode_t d_mode) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_set_security_param(esp_bt_sp_param_t param_type,
+                                        void *value, uint8_t len) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_set_pin(esp_bt_pin_type_t pin_type, uint8_t pin_code_len,
+                             esp_bt_pin_code_t pin_code) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_pin_reply(esp_bd_addr_t bd_addr, bool accept,
+                               uint8_t pin_code_len,
+                               esp_bt_pin_code_t pin_code) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_ssp_confirm_reply(esp_bd_addr_t bd_addr, bool accept) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_ssp_passkey_reply(esp_bd_addr_t bd_addr, bool accept,
+                                       uint32_t passkey) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_read_rssi_delta(esp_bd_addr_t remote_addr) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_read_remote_name(esp_bd_addr_t remote_bda) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_set_device_name(const char *name) { return ESP_OK; }
+esp_err_t esp_bt_gap_start_discovery(esp_bt_inq_mode_t mode, uint8_t inq_len,
+                                     uint8_t num_rsps) {
+  return ESP_OK;
+}
+esp_err_t esp_bt_gap_cancel_discovery() { return ESP_OK; }
+bool esp_bt_gap_is_valid_cod(uint32_t cod) { return false; }
+uint32_t esp_bt_gap_get_cod_srvc(uint32_t cod) { return 0; }
+uint8_t *esp_bt_gap_resolve_eir_data(uint8_t *eir, esp_bt_eir_type_t type,
+                                     uint8_t *length) {
+  if (length != nullptr) *length = 0;
+  return nullptr;
+}
+
+// a2dp
+
+esp_err_t esp_a2d_register_callback(esp_a2d_cb_t callback) { return ESP_OK; }
+esp_err_t esp_a2d_sink_init() { return ESP_OK; }
+esp_err_t esp_a2d_sink_deinit() { return ESP_OK; }
+esp_err_t esp_a2d_sink_connect(esp_bd_addr_t remote_bda) { return ESP_OK; }
+esp_err_t esp_a2d_sink_disconnect(esp_bd_addr_t remote_bda) { return ESP_OK; }
+esp_err_t esp_a2d_sink_register_data_callback(esp_a2d_sink_data_cb_t callback) {
+  return ESP_OK;
+}
+esp_err_t esp_a2d_sink_register_audio_data_callback(
+    esp_a2d_sink_audio_data_cb_t callback) {
+  return ESP_OK;
+}
+esp_err_t esp_a2d_sink_register_stream_endpoint(uint8_t seid,
+                                                const esp_a2d_mcc_t *mcc) {
+  return ESP_OK;
+}
+void esp_a2d_audio_buff_free(esp_a2d_audio_buff_t *audio_buf) {}
+esp_err_t esp_a2d_source_init() { return ESP_OK; }
+esp_err_t esp_a2d_source_deinit() { return ESP_OK; }
+esp_err_t esp_a2d_source_connect(esp_bd_addr_t remote_bda) { return ESP_OK; }
+esp_err_t esp_a2d_source_disconnect(esp_bd_addr_t remote_bda) {
+  return ESP_OK;
+}
+esp_err_t esp_a2d_source_register_data_callback(
+    esp_a2d_source_data_cb_t callback) {
+  return ESP_OK;
+}
+esp_err_t esp_a2d_media_ctrl(esp_a2d_media_ctrl_t ctrl) { return ESP_OK; }
+
+// avrc
+
+esp_err_t esp_avrc_ct_register_callback(esp_avrc_ct_cb_t callback) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_ct_init() { return ESP_OK; }
+esp_err_t esp_avrc_ct_deinit() { return ESP_OK; }
+esp_err_t esp_avrc_ct_send_get_rn_capabilities_cmd(uint8_t tl) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_ct_send_metadata_cmd(uint8_t tl, uint8_t attr_mask) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_ct_send_passthrough_cmd(uint8_t tl, uint8_t key_code,
+                                           uint8_t key_state) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_ct_send_register_notification_cmd(uint8_t tl,
+                                                     uint8_t event_id,
+                                                     uint32_t event_parameter) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_ct_send_set_absolute_volume_cmd(uint8_t tl,
+                                                   uint8_t volume) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_tg_register_callback(esp_avrc_tg_cb_t callback) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_tg_init() { return ESP_OK; }
+esp_err_t esp_avrc_tg_deinit() { return ESP_OK; }
+esp_err_t esp_avrc_tg_get_psth_cmd_filter(esp_avrc_psth_filter_t filter,
+                                          esp_avrc_psth_bit_mask_t *cmd_set) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_tg_set_psth_cmd_filter(
+    esp_avrc_psth_filter_t filter, const esp_avrc_psth_bit_mask_t *cmd_set) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_tg_get_rn_evt_cap(esp_avrc_rn_cap_t cap,
+                                     esp_avrc_rn_evt_cap_mask_t *evt_set) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_tg_set_rn_evt_cap(
+    const esp_avrc_rn_evt_cap_mask_t *evt_set) {
+  return ESP_OK;
+}
+esp_err_t esp_avrc_tg_send_rn_rsp(esp_avrc_rn_event_ids_t event_id,
+                                  esp_avrc_rn_rsp_t rsp,
+                                  esp_avrc_rn_param_t *param) {
+  return ESP_OK;
+}
+
+bool esp_avrc_rn_evt_bit_mask_operation(esp_avrc_bit_mask_op_t op,
+                                        esp_avrc_rn_evt_cap_mask_t *events,
+                                        esp_avrc_rn_event_ids_t event_id) {
+  uint16_t mask = 1 << event_id;
+  switch (op) {
+    case ESP_AVRC_BIT_MASK_OP_SET:
+      events->bits |= mask;
+      return true;
+    case ESP_AVRC_BIT_MASK_OP_CLEAR:
+      events->bits &= ~mask;
+      return true;
+    default:
+      return (events->bits & mask) != 0;
+  }
+}
+
+// spp
+
+esp_err_t esp_spp_init(esp_spp_mode_t mode) { return ESP_OK; }
+esp_err_t esp_spp_enhanced_init(const esp_spp_cfg_t *cfg) { return ESP_OK; }
+
+// nvs
+
+esp_err_t nvs_flash_init() { return ESP_OK; }
+esp_err_t nvs_flash_erase() { return ESP_OK; }
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode,
+                   nvs_handle_t *handle) {
+  *handle = 1;
+  return ESP_OK;
+}
+void nvs_close(nvs_handle_t handle) {}
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *value,
+                       size_t *length) {
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value,
+                       size_t length) {
+  return ESP_OK;
+}
+esp_err_t nvs_commit(nvs_handle_t handle) { return ESP_OK; }
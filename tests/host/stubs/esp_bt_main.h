@@ -0,0 +1,21 @@
+#pragma once
+// Host replacement of the ESP-IDF Bluedroid API
+
+#include "esp_bt_defs.h"
+
+typedef enum {
+  ESP_BLUEDROID_STATUS_UNINITIALIZED,
+  ESP_BLUEDROID_STATUS_INITIALIZED,
+  ESP_BLUEDROID_STATUS_ENABLED
+} esp_bluedroid_status_t;
+
+typedef struct {
+  bool ssp_en;
+} esp_bluedroid_config_t;
+
+esp_bluedroid_status_t esp_bluedroid_get_status();
+esp_err_t esp_bluedroid_init();
+esp_err_t esp_bluedroid_init_with_cfg(esp_bluedroid_config_t *cfg);
+esp_err_t esp_bluedroid_deinit();
+esp_err_t esp_bluedroid_enable();
+esp_err_t esp_bluedroid_disable();
@@ -0,0 +1,161 @@
+#pragma once
+// Host replacement of the ESP-IDF classic Bluetooth GAP API
+
+#include "esp_bt_defs.h"
+
+#define ESP_BT_GAP_MAX_BDNAME_LEN 248
+
+typedef enum {
+  ESP_BT_GAP_DISC_RES_EVT,
+  ESP_BT_GAP_DISC_STATE_CHANGED_EVT,
+  ESP_BT_GAP_RMT_SRVCS_EVT,
+  ESP_BT_GAP_RMT_SRVC_REC_EVT,
+  ESP_BT_GAP_AUTH_CMPL_EVT,
+  ESP_BT_GAP_PIN_REQ_EVT,
+  ESP_BT_GAP_CFM_REQ_EVT,
+  ESP_BT_GAP_KEY_NOTIF_EVT,
+  ESP_BT_GAP_KEY_REQ_EVT,
+  ESP_BT_GAP_READ_RSSI_DELTA_EVT,
+  ESP_BT_GAP_READ_REMOTE_NAME_EVT,
+  ESP_BT_GAP_MODE_CHG_EVT,
+  ESP_BT_GAP_ACL_CONN_CMPL_STAT_EVT,
+  ESP_BT_GAP_ACL_DISCONN_CMPL_STAT_EVT,
+  ESP_BT_GAP_ENC_CHG_EVT,
+  ESP_BT_GAP_GET_DEV_NAME_CMPL_EVT
+} esp_bt_gap_cb_event_t;
+
+typedef enum {
+  ESP_BT_GAP_DISCOVERY_STOPPED,
+  ESP_BT_GAP_DISCOVERY_STARTED
+} esp_bt_gap_discovery_state_t;
+
+typedef enum {
+  ESP_BT_GAP_DEV_PROP_BDNAME = 1,
+  ESP_BT_GAP_DEV_PROP_COD,
+  ESP_BT_GAP_DEV_PROP_RSSI,
+  ESP_BT_GAP_DEV_PROP_EIR
+} esp_bt_gap_dev_prop_type_t;
+
+typedef struct {
+  esp_bt_gap_dev_prop_type_t type;
+  int len;
+  void *val;
+} esp_bt_gap_dev_prop_t;
+
+typedef enum { ESP_BT_NON_CONNECTABLE, ESP_BT_CONNECTABLE } esp_bt_connection_mode_t;
+
+typedef enum {
+  ESP_BT_NON_DISCOVERABLE,
+  ESP_BT_LIMITED_DISCOVERABLE,
+  ESP_BT_GENERAL_DISCOVERABLE
+} esp_bt_discovery_mode_t;
+
+typedef enum { ESP_BT_INQ_MODE_GENERAL_INQUIRY } esp_bt_inq_mode_t;
+
+typedef enum {
+  ESP_BT_COD_SRVC_RENDERING = 0x20,
+  ESP_BT_COD_SRVC_AUDIO = 0x100,
+  ESP_BT_COD_SRVC_TELEPHONY = 0x200
+} esp_bt_cod_srvc_t;
+
+typedef enum {
+  ESP_BT_EIR_TYPE_SHORT_LOCAL_NAME = 0x08,
+  ESP_BT_EIR_TYPE_CMPL_LOCAL_NAME = 0x09
+} esp_bt_eir_type_t;
+
+typedef enum { ESP_BT_SP_IOCAP_MODE } esp_bt_sp_param_t;
+typedef uint8_t esp_bt_io_cap_t;
+#define ESP_BT_IO_CAP_IO 1
+#define ESP_BT_IO_CAP_NONE 3
+
+typedef uint8_t esp_bt_pin_code_t[16];
+typedef enum { ESP_BT_PIN_TYPE_VARIABLE, ESP_BT_PIN_TYPE_FIXED } esp_bt_pin_type_t;
+
+typedef union {
+  struct {
+    esp_bd_addr_t bda;
+    int num_prop;
+    esp_bt_gap_dev_prop_t *prop;
+  } disc_res;
+  struct {
+    esp_bt_gap_discovery_state_t state;
+  } disc_st_chg;
+  struct {
+    esp_bt_status_t stat;
+    uint8_t device_name[ESP_BT_GAP_MAX_BDNAME_LEN + 1];
+    esp_bd_addr_t bda;
+  } auth_cmpl;
+  struct {
+    esp_bd_addr_t bda;
+    bool min_16_digit;
+  } pin_req;
+  struct {
+    esp_bd_addr_t bda;
+    uint32_t num_val;
+  } cfm_req;
+  struct {
+    esp_bd_addr_t bda;
+    uint32_t passkey;
+  } key_notif;
+  struct {
+    esp_bd_addr_t bda;
+  } key_req;
+  struct read_rssi_delta_param {
+    esp_bd_addr_t bda;
+    esp_bt_status_t stat;
+    int8_t rssi_delta;
+  } read_rssi_delta;
+  struct {
+    esp_bd_addr_t bda;
+    esp_bt_status_t stat;
+    uint8_t rmt_name[ESP_BT_GAP_MAX_BDNAME_LEN];
+  } read_rmt_name;
+  struct {
+    esp_bd_addr_t bda;
+    int mode;
+  } mode_chg;
+  struct {
+    esp_bt_status_t stat;
+    uint16_t handle;
+    esp_bd_addr_t bda;
+  } acl_conn_cmpl_stat;
+  struct {
+    int reason;
+    uint16_t handle;
+    esp_bd_addr_t bda;
+  } acl_disconn_cmpl_stat;
+  struct {
+    esp_bd_addr_t bda;
+    int enc_mode;
+  } enc_chg;
+  struct {
+    esp_bt_status_t status;
+    char *name;
+  } get_dev_name_cmpl;
+} esp_bt_gap_cb_param_t;
+
+typedef void (*esp_bt_gap_cb_t)(esp_bt_gap_cb_event_t event,
+                                esp_bt_gap_cb_param_t *param);
+
+esp_err_t esp_bt_gap_register_callback(esp_bt_gap_cb_t callback);
+esp_err_t esp_bt_gap_set_scan_mode(esp_bt_connection_mode_t c_mode,
+                                   esp_bt_discovery_mode_t d_mode);
+esp_err_t esp_bt_gap_set_security_param(esp_bt_sp_param_t param_type,
+                                        void *value, uint8_t len);
+esp_err_t esp_bt_gap_set_pin(esp_bt_pin_type_t pin_type, uint8_t pin_code_len,
+                             esp_bt_pin_code_t pin_code);
+esp_err_t esp_bt_gap_pin_reply(esp_bd_addr_t bd_addr, bool accept,
+                               uint8_t pin_code_len, esp_bt_pin_code_t pin_code);
+esp_err_t esp_bt_gap_ssp_confirm_reply(esp_bd_addr_t bd_addr, bool accept);
+esp_err_t esp_bt_gap_ssp_passkey_reply(esp_bd_addr_t bd_addr, bool accept,
+                                       uint32_t passkey);
+esp_err_t esp_bt_gap_read_rssi_delta(esp_bd_addr_t remote_addr);
+esp_err_t esp_bt_gap_read_remote_name(esp_bd_addr_t remote_bda);
+esp_err_t esp_bt_gap_set_device_name(const char *name);
+esp_err_t esp_bt_gap_start_discovery(esp_bt_inq_mode_t mode,
+                                     uint8_t inq_len, uint8_t num_rsps);
+esp_err_t esp_bt_gap_cancel_discovery();
+bool esp_bt_gap_is_valid_cod(uint32_t cod);
+uint32_t esp_bt_gap_get_cod_srvc(uint32_t cod);
+uint8_t *esp_bt_gap_resolve_eir_data(uint8_t *eir, esp_bt_eir_type_t type,
+                                     uint8_t *length);
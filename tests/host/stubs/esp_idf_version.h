@@ -0,0 +1,11 @@
+#pragma once
+// Host replacement of the ESP-IDF version: the stubs follow the API of 5.5
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) \
+  (((major) << 16) | ((minor) << 8) | (patch))
+#define ESP_IDF_VERSION_MAJOR 5
+#define ESP_IDF_VERSION_MINOR 5
+#define ESP_IDF_VERSION_PATCH 0
+#define ESP_IDF_VERSION                                     \
+  ESP_IDF_VERSION_VAL(ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, \
+                      ESP_IDF_VERSION_PATCH)
@@ -0,0 +1,16 @@
+#pragma once
+// Minimal replacement of the ESP-IDF logger for the host tests: errors and
+// warnings are printed, the rest is ignored
+
+#include <inttypes.h>
+#include <stdio.h>
+
+/// accepts the arguments of the ignored log levels w/o evaluating the format
+template <typename... Args>
+inline void esp_log_ignore(const char *tag, const char *fmt, Args...) {}
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) esp_log_ignore(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) esp_log_ignore(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...) esp_log_ignore(tag, fmt, ##__VA_ARGS__)
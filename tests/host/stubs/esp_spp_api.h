@@ -0,0 +1,15 @@
+#pragma once
+// Host replacement of the ESP-IDF SPP API
+
+#include "esp_bt_defs.h"
+
+typedef enum { ESP_SPP_MODE_CB, ESP_SPP_MODE_VFS } esp_spp_mode_t;
+
+typedef struct {
+  esp_spp_mode_t mode;
+} esp_spp_cfg_t;
+
+#define BT_SPP_DEFAULT_CONFIG() {ESP_SPP_MODE_CB}
+
+esp_err_t esp_spp_init(esp_spp_mode_t mode);
+esp_err_t esp_spp_enhanced_init(const esp_spp_cfg_t *cfg);
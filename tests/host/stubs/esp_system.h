@@ -0,0 +1,8 @@
+#pragma once
+// Host replacement of the ESP-IDF system functions
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+inline uint32_t esp_get_free_heap_size() { return 0; }
@@ -0,0 +1,5 @@
+#pragma once
+// Host replacement of the ESP-IDF task watchdog: there is no watchdog on the
+// host
+
+#include "esp_err.h"
@@ -0,0 +1,13 @@
+#pragma once
+// Host replacement of the ESP-IDF high resolution timer
+
+#include <stdint.h>
+
+#include <chrono>
+
+/// time since the start of the host in us
+inline int64_t esp_timer_get_time() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
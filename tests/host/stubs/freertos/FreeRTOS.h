@@ -0,0 +1,37 @@
+#pragma once
+// Host replacement of the FreeRTOS definitions: the tasks are mapped to
+// threads and the primitives are implemented in freertos_host.cpp
+
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOSConfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef int portMUX_TYPE;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define portMAX_DELAY ((TickType_t)0xffffffff)
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms) / portTICK_PERIOD_MS)
+#define portMUX_INITIALIZER_UNLOCKED 0
+
+/// critical sections of all tasks share one lock
+void host_enter_critical(portMUX_TYPE *mux);
+void host_exit_critical(portMUX_TYPE *mux);
+
+#define portENTER_CRITICAL(mux) host_enter_critical(mux)
+#define portEXIT_CRITICAL(mux) host_exit_critical(mux)
+#define taskENTER_CRITICAL(mux) host_enter_critical(mux)
+#define taskEXIT_CRITICAL(mux) host_exit_critical(mux)
+
+// newlib locks which are provided by the ESP-IDF
+typedef int _lock_t;
+void _lock_init(_lock_t *lock);
+void _lock_acquire(_lock_t *lock);
+void _lock_release(_lock_t *lock);
@@ -0,0 +1,5 @@
+#pragma once
+// Host replacement of the FreeRTOS configuration
+
+#define configMAX_PRIORITIES 25
+#define configTICK_RATE_HZ 1000
@@ -0,0 +1,16 @@
+#pragma once
+// Host replacement of the FreeRTOS queue API
+
+#include "freertos/FreeRTOS.h"
+
+struct HostQueue;
+typedef HostQueue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+// the ESP-IDF makes the semaphores available with the queues
+#include "freertos/semphr.h"
@@ -0,0 +1,5 @@
+#pragma once
+// Host replacement of the ESP-IDF ringbuffer: the library uses its own
+// A2DPRingBuffer
+
+#include "freertos/FreeRTOS.h"
@@ -0,0 +1,12 @@
+#pragma once
+// Host replacement of the FreeRTOS semaphore API: only binary semaphores
+
+#include "freertos/FreeRTOS.h"
+
+struct HostSemaphore;
+typedef HostSemaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
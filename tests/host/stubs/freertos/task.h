@@ -0,0 +1,32 @@
+#pragma once
+// Host replacement of the FreeRTOS task API: each task is a thread
+
+#include "freertos/FreeRTOS.h"
+
+struct HostTask;
+typedef HostTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define tskNO_AFFINITY 0x7fffffff
+#define taskYIELD() vTaskDelay(0)
+
+/// the core and the stack size are ignored on the host
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name,
+                                   uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char *name,
+                              uint32_t stack_size, void *arg,
+                              UBaseType_t priority, TaskHandle_t *handle) {
+  return xTaskCreatePinnedToCore(function, name, stack_size, arg, priority,
+                                 handle, tskNO_AFFINITY);
+}
+
+/// Deleting another task waits until it has reached its next FreeRTOS call
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
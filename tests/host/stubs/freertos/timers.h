@@ -0,0 +1,20 @@
+#pragma once
+// Host replacement of the FreeRTOS software timers: the callbacks are called
+// by a timer task like in FreeRTOS
+
+#include "freertos/FreeRTOS.h"
+
+struct tmrTimerControl;
+typedef tmrTimerControl *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period,
+                           UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t callback);
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks);
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+                              TickType_t ticks);
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer);
+void *pvTimerGetTimerID(TimerHandle_t timer);
@@ -0,0 +1,353 @@
+// Host implementation of the FreeRTOS primitives which are used by the
+// library: tasks are threads and all primitives share one lock and one
+// condition variable, which is good enough for a few tasks
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+
+struct HostTask {
+  std::thread thread;
+  uint32_t notifications = 0;
+  bool is_deleted = false;
+  bool is_self_deleted = false;
+};
+
+struct HostQueue {
+  size_t length;
+  size_t item_size;
+  std::deque<std::vector<uint8_t>> items;
+};
+
+struct HostSemaphore {
+  bool is_given = false;
+};
+
+struct tmrTimerControl {
+  TickType_t period;
+  bool is_auto_reload;
+  bool is_active = false;
+  bool is_deleted = false;
+  void *id;
+  TimerCallbackFunction_t callback;
+  std::chrono::steady_clock::time_point due;
+};
+
+/// thrown in a task which was deleted: ends its thread
+struct HostTaskDeleted {};
+
+// never destructed, so that detached tasks can still use them at exit
+static std::mutex &host_lock = *new std::mutex();
+static std::condition_variable &host_cv = *new std::condition_variable();
+static std::recursive_mutex &host_critical = *new std::recursive_mutex();
+static std::vector<tmrTimerControl *> &host_timers =
+    *new std::vector<tmrTimerControl *>();
+static bool host_timer_task_started = false;
+static thread_local HostTask *host_current_task = nullptr;
+static thread_local HostTask host_thread_task;
+
+static HostTask *current_task() {
+  // the main thread (or any other thread) is treated like a task
+  if (host_current_task == nullptr) host_current_task = &host_thread_task;
+  return host_current_task;
+}
+
+/// waits until the predicate is true: false if the ticks have passed. A
+/// deleted task does not return from here.
+template <typename Predicate>
+static bool host_wait(std::unique_lock<std::mutex> &lock, TickType_t ticks,
+                      Predicate predicate) {
+  HostTask *task = current_task();
+  auto is_done = [&] { return task->is_deleted || predicate(); };
+  bool result = true;
+  if (ticks == portMAX_DELAY) {
+    host_cv.wait(lock, is_done);
+  } else {
+    result = host_cv.wait_for(
+        lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), is_done);
+  }
+  if (task->is_deleted) throw HostTaskDeleted();
+  return result;
+}
+
+void host_enter_critical(portMUX_TYPE *mux) { host_critical.lock(); }
+
+void host_exit_critical(portMUX_TYPE *mux) { host_critical.unlock(); }
+
+void _lock_init(_lock_t *lock) { *lock = 0; }
+
+void _lock_acquire(_lock_t *lock) { host_critical.lock(); }
+
+void _lock_release(_lock_t *lock) { host_critical.unlock(); }
+
+// tasks
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name,
+                                   uint32_t stack_size, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core) {
+  HostTask *task = new HostTask();
+  // the handle must be valid before the task is running
+  if (handle != nullptr) *handle = task;
+  std::lock_guard<std::mutex> guard(host_lock);
+  task->thread = std::thread([task, function, arg] {
+    host_current_task = task;
+    try {
+      function(arg);
+    } catch (HostTaskDeleted &) {
+    }
+    std::lock_guard<std::mutex> guard(host_lock);
+    if (task->is_self_deleted) {
+      task->thread.detach();
+      delete task;
+    }
+  });
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  HostTask *self = current_task();
+  if (task == nullptr || task == self) {
+    std::lock_guard<std::mutex> guard(host_lock);
+    self->is_self_deleted = true;
+    throw HostTaskDeleted();
+  }
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    task->is_deleted = true;
+  }
+  host_cv.notify_all();
+  // the task ends with its next blocking call
+  task->thread.join();
+  delete task;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(host_lock);
+  if (ticks == 0) {
+    if (current_task()->is_deleted) throw HostTaskDeleted();
+    lock.unlock();
+    std::this_thread::yield();
+    return;
+  }
+  host_wait(lock, ticks, [] { return false; });
+}
+
+TickType_t xTaskGetTickCount() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+             .count() /
+         portTICK_PERIOD_MS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return current_task(); }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    task->notifications++;
+  }
+  host_cv.notify_all();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(host_lock);
+  HostTask *task = current_task();
+  host_wait(lock, ticks, [task] { return task->notifications > 0; });
+  uint32_t result = task->notifications;
+  if (result > 0) task->notifications = clear_on_exit ? 0 : result - 1;
+  return result;
+}
+
+// queues
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  HostQueue *queue = new HostQueue();
+  queue->length = length;
+  queue->item_size = item_size;
+  return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> guard(host_lock);
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item,
+                      TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(host_lock);
+  if (!host_wait(lock, ticks,
+                 [queue] { return queue->items.size() < queue->length; })) {
+    return pdFAIL;
+  }
+  const uint8_t *data = (const uint8_t *)item;
+  queue->items.emplace_back(data, data + queue->item_size);
+  lock.unlock();
+  host_cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(host_lock);
+  if (!host_wait(lock, ticks, [queue] { return !queue->items.empty(); })) {
+    return pdFAIL;
+  }
+  memcpy(item, queue->items.front().data(), queue->item_size);
+  queue->items.pop_front();
+  lock.unlock();
+  host_cv.notify_all();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> guard(host_lock);
+  return queue->items.size();
+}
+
+// semaphores
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return new HostSemaphore(); }
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> guard(host_lock);
+  delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+  std::unique_lock<std::mutex> lock(host_lock);
+  if (!host_wait(lock, ticks, [semaphore] { return semaphore->is_given; })) {
+    return pdFALSE;
+  }
+  semaphore->is_given = false;
+  return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    // a binary semaphore can only be given once
+    if (semaphore->is_given) return pdFALSE;
+    semaphore->is_given = true;
+  }
+  host_cv.notify_all();
+  return pdTRUE;
+}
+
+// timers
+
+/// calls the callbacks of the due timers like the FreeRTOS timer task
+static void host_timer_task(void *arg) {
+  std::unique_lock<std::mutex> lock(host_lock);
+  while (true) {
+    auto now = std::chrono::steady_clock::now();
+    auto next = now + std::chrono::seconds(1);
+    tmrTimerControl *due = nullptr;
+    for (auto it = host_timers.begin(); it != host_timers.end();) {
+      tmrTimerControl *timer = *it;
+      if (timer->is_deleted) {
+        it = host_timers.erase(it);
+        delete timer;
+        continue;
+      }
+      if (timer->is_active) {
+        if (timer->due <= now && due == nullptr) due = timer;
+        if (timer->due < next) next = timer->due;
+      }
+      ++it;
+    }
+    if (due == nullptr) {
+      host_cv.wait_until(lock, next);
+      continue;
+    }
+    if (due->is_auto_reload) {
+      due->due = now + std::chrono::milliseconds(due->period *
+                                                 portTICK_PERIOD_MS);
+    } else {
+      due->is_active = false;
+    }
+    // the callback can use the timer API
+    lock.unlock();
+    due->callback(due);
+    lock.lock();
+  }
+}
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period,
+                           UBaseType_t auto_reload, void *id,
+                           TimerCallbackFunction_t callback) {
+  tmrTimerControl *timer = new tmrTimerControl();
+  timer->period = period;
+  timer->is_auto_reload = auto_reload;
+  timer->id = id;
+  timer->callback = callback;
+  bool is_start = false;
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    host_timers.push_back(timer);
+    is_start = !host_timer_task_started;
+    host_timer_task_started = true;
+  }
+  if (is_start) {
+    TaskHandle_t handle;
+    xTaskCreatePinnedToCore(host_timer_task, "Tmr Svc", 0, nullptr, 1,
+                            &handle, tskNO_AFFINITY);
+    handle->thread.detach();
+  }
+  return timer;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t ticks) {
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    // released by the timer task
+    timer->is_active = false;
+    timer->is_deleted = true;
+  }
+  host_cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t ticks) {
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    timer->is_active = true;
+    timer->due = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(timer->period * portTICK_PERIOD_MS);
+  }
+  host_cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t ticks) {
+  std::lock_guard<std::mutex> guard(host_lock);
+  timer->is_active = false;
+  return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period,
+                              TickType_t ticks) {
+  {
+    std::lock_guard<std::mutex> guard(host_lock);
+    timer->period = period;
+  }
+  // like in FreeRTOS this also starts the timer
+  return xTimerStart(timer, ticks);
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer) {
+  std::lock_guard<std::mutex> guard(host_lock);
+  return timer->is_active ? pdTRUE : pdFALSE;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) { return timer->id; }
@@ -0,0 +1,7 @@
+#pragma once
+// Host replacement of the ESP-IDF nvs flash initialization
+
+#include "nvs.h"
+
+esp_err_t nvs_flash_init();
+esp_err_t nvs_flash_erase();
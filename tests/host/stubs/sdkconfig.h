@@ -0,0 +1,5 @@
+#pragma once
+// Host replacement of the ESP-IDF project configuration: we pretend to be an
+// ESP32, so that the platform check of the library passes
+
+#define CONFIG_IDF_TARGET_ESP32 1
@@ -0,0 +1,2 @@
+#pragma once
+// Host replacement of the Xtensa API: nothing is used by the library
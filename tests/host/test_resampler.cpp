@@ -0,0 +1,99 @@
+// Host test of A2DPLinearResampler and A2DPPolyphaseResampler: number of
+// frames, unity gain and the signal to noise ratio of a sine
+
+#include <math.h>
+
+#include <vector>
+
+#include "A2DPResampler.h"
+#include "host_test.h"
+
+void test_linear() {
+  A2DPLinearResampler resampler;
+  resampler.set_factor(1.001f);
+  Frame in[1000];
+  for (int j = 0; j < 1000; j++) in[j] = Frame(1000, -1000);
+  size_t total = 0;
+  for (int block = 0; block < 100; block++) {
+    total += resampler.resample(in, 1000, [&](const Frame& frame) {
+      CHECK(frame.channel1 == 1000 || block == 0);
+    });
+  }
+  // 100000 / 1.001
+  CHECK(total >= 99899 && total <= 99901);
+}
+
+/// Converts a sine and provides the SNR in dB of the second half of the output
+double sine_snr(int inRate, int outRate, A2DPResamplerQuality quality,
+                double freq, size_t* outFrames = nullptr) {
+  A2DPPolyphaseResampler resampler;
+  if (!resampler.begin(inRate, outRate, quality)) return 0;
+  const int count = 8192;
+  const double amplitude = 16000;
+  std::vector<Frame> out(count);
+  size_t in_pos = 0;
+  size_t done = 0;
+  // pull the output in blocks as the A2DP source does
+  while (done < count) {
+    size_t needed = resampler.input_frames(128);
+    Frame* area = resampler.input_area(needed);
+    for (size_t j = 0; j < needed; j++) {
+      int16_t value = lrint(amplitude * sin(2 * M_PI * freq * (in_pos + j) / inRate));
+      area[j] = Frame(value, -value);
+    }
+    resampler.commit_input(needed);
+    in_pos += needed;
+    done += resampler.read(out.data() + done, count - done < 128 ? count - done : 128);
+  }
+  if (outFrames != nullptr) *outFrames = in_pos;
+  // the output is delayed by half of the filter length
+  double delay = resampler.filter_taps() / 2;
+  double signal = 0;
+  double noise = 0;
+  for (int j = count / 2; j < count; j++) {
+    double t = (double)j * inRate / outRate - delay;
+    double ideal = amplitude * sin(2 * M_PI * freq * t / inRate);
+    double error = out[j].channel1 - ideal;
+    signal += ideal * ideal;
+    noise += error * error;
+  }
+  return 10 * log10(signal / noise);
+}
+
+void test_polyphase() {
+  const char* names[] = {"linear", "low", "medium", "high"};
+  const int rates[][2] = {{48000, 44100}, {44100, 48000}, {16000, 44100}};
+  for (auto& rate : rates) {
+    for (int q = A2DP_RESAMPLE_LINEAR; q <= A2DP_RESAMPLE_HIGH; q++) {
+      double snr_1k = sine_snr(rate[0], rate[1], (A2DPResamplerQuality)q, 1000);
+      double snr_hi = sine_snr(rate[0], rate[1], (A2DPResamplerQuality)q,
+                               rate[0] < rate[1] ? rate[0] / 4.8 : 10000);
+      printf("%5d -> %5d %-6s: %5.1f dB @ 1 kHz, %5.1f dB @ high freq\n",
+             rate[0], rate[1], names[q], snr_1k, snr_hi);
+      if (q >= A2DP_RESAMPLE_MEDIUM) {
+        CHECK(snr_1k > 70);
+        CHECK(snr_hi > 70);
+      }
+    }
+  }
+
+  // constant input keeps the level
+  A2DPPolyphaseResampler resampler;
+  resampler.begin(44100, 48000, A2DP_RESAMPLE_HIGH);
+  Frame in[4096];
+  for (int j = 0; j < 4096; j++) in[j] = Frame(10000, -10000);
+  resampler.write(in, 4096);
+  Frame out[5000];
+  size_t n = resampler.read(out, 5000);
+  CHECK(n > 4400 && n <= 4459);
+  for (size_t j = 100; j < n; j++) {
+    CHECK(abs(out[j].channel1 - 10000) <= 1);
+    CHECK(abs(out[j].channel2 + 10000) <= 1);
+  }
+}
+
+int main() {
+  test_linear();
+  test_polyphase();
+  return TEST_RESULT();
+}
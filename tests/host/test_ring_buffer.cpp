@@ -0,0 +1,85 @@
+// Host test of A2DPRingBuffer: wrap around, views and one producer and one
+// consumer in separate threads
+
+#include <thread>
+
+#include "A2DPRingBuffer.h"
+#include "freertos/task.h"
+#include "host_test.h"
+
+void test_wrap_around() {
+  A2DPRingBuffer ring;
+  CHECK(ring.resize(100));
+  uint8_t data[70];
+  uint8_t result[70];
+  for (int round = 0; round < 10; round++) {
+    for (int j = 0; j < 70; j++) data[j] = round * 70 + j;
+    CHECK(ring.write(data, 70) == 70);
+    CHECK(ring.available() == 70);
+    CHECK(ring.available_for_write() == 30);
+    CHECK(ring.write(data, 70) == 30);
+    CHECK(ring.read(result, 70) == 70);
+    for (int j = 0; j < 70; j++) CHECK(result[j] == data[j]);
+    CHECK(ring.read(result, 70) == 30);
+  }
+  CHECK(ring.available() == 0);
+}
+
+void test_views() {
+  A2DPRingBuffer ring;
+  ring.resize(64);
+  uint8_t data[48] = {0};
+  ring.write(data, 48);
+  ring.read(data, 48);
+  // the free memory wraps around the end of the buffer
+  A2DPRingBufferView view = ring.write_view();
+  CHECK(view.len[0] == 16 && view.len[1] == 48 && view.total() == 64);
+  memset(view.data[0], 1, view.len[0]);
+  memset(view.data[1], 2, 8);
+  ring.commit(view.len[0] + 8);
+  A2DPRingBufferView read = ring.read_view();
+  CHECK(read.total() == 24);
+  CHECK(read.data[0][0] == 1 && read.data[1][7] == 2);
+  ring.consume(read.total());
+  CHECK(ring.available() == 0);
+}
+
+void test_threads() {
+  A2DPRingBuffer ring;
+  ring.resize(512);
+  const uint32_t total = 1000000;
+  std::thread producer([&]() {
+    uint32_t value = 0;
+    while (value < total) {
+      uint8_t data[97];
+      size_t n = 0;
+      while (n < sizeof(data) && value + n < total) {
+        data[n] = (value + n) & 0xFF;
+        n++;
+      }
+      size_t written = ring.write(data, n);
+      value += written;
+      if (written == 0) vTaskDelay(0);
+    }
+  });
+  uint32_t value = 0;
+  int errors = 0;
+  while (value < total) {
+    uint8_t data[61];
+    size_t n = ring.read(data, sizeof(data));
+    for (size_t j = 0; j < n; j++) {
+      if (data[j] != ((value + j) & 0xFF)) errors++;
+    }
+    value += n;
+    if (n == 0) vTaskDelay(0);
+  }
+  producer.join();
+  CHECK(errors == 0);
+}
+
+int main() {
+  test_wrap_around();
+  test_views();
+  test_threads();
+  return TEST_RESULT();
+}
@@ -0,0 +1,118 @@
+// Host test of A2DPVolumeControl: volume, channel swap, mono downmix and the
+// gain ramps
+
+#include "A2DPVolumeControl.h"
+#include "host_test.h"
+
+const int frames = 1024;
+Frame in[frames];
+Frame out[frames];
+
+void fill() {
+  for (int j = 0; j < frames; j++) in[j] = Frame(1000 + j, -1000 - j);
+}
+
+void test_unity() {
+  A2DPDefaultVolumeControl vc;
+  A2DPVolumeControl& control = vc;
+  control.set_ramp_frames(0);
+  fill();
+  control.update_audio_data(in, out, frames, false);
+  for (int j = 0; j < frames; j++) {
+    CHECK(out[j].channel1 == in[j].channel1);
+    CHECK(out[j].channel2 == in[j].channel2);
+  }
+  CHECK(control.is_unity());
+}
+
+void test_swap_and_volume() {
+  A2DPLinearVolumeControl vc;
+  A2DPVolumeControl& control = vc;
+  control.set_ramp_frames(0);
+  control.set_enabled(true);
+  control.set_volume(64);  // 64 / 128 = 0.5
+  fill();
+  control.update_audio_data(in, out, frames, true);
+  for (int j = 0; j < frames; j++) {
+    CHECK(out[j].channel1 == in[j].channel2 / 2);
+    CHECK(out[j].channel2 == in[j].channel1 / 2);
+  }
+  CHECK(!control.is_unity());
+}
+
+void test_mono_downmix() {
+  A2DPDefaultVolumeControl vc;
+  A2DPVolumeControl& control = vc;
+  control.set_ramp_frames(0);
+  control.set_mono_downmix(true);
+  for (int j = 0; j < frames; j++) in[j] = Frame(2000, 1000);
+  control.update_audio_data(in, out, frames, false);
+  for (int j = 0; j < frames; j++) {
+    CHECK(out[j].channel1 == 1500);
+    CHECK(out[j].channel2 == 1500);
+  }
+}
+
+void test_fade() {
+  A2DPDefaultVolumeControl vc;
+  A2DPVolumeControl& control = vc;
+  control.set_ramp_frames(256);
+  for (int j = 0; j < frames; j++) in[j] = Frame(16000, 16000);
+  // first block starts w/o ramp
+  control.update_audio_data(in, out, frames, false);
+  CHECK(out[0].channel1 == 16000);
+
+  // fade out: monotonic down to silence within the ramp length
+  control.fade_out();
+  control.update_audio_data(in, out, frames, false);
+  for (int j = 1; j < frames; j++) CHECK(out[j].channel1 <= out[j - 1].channel1);
+  CHECK(out[0].channel1 > 0);
+  CHECK(out[256].channel1 == 0 && out[frames - 1].channel1 == 0);
+  CHECK(control.is_faded_out());
+
+  // fade in: monotonic up to the full level
+  control.fade_in();
+  control.update_audio_data(in, out, frames, false);
+  for (int j = 1; j < frames; j++) CHECK(out[j].channel1 >= out[j - 1].channel1);
+  CHECK(out[frames - 1].channel1 == 16000);
+
+  // immediate fade out
+  control.fade_out(true);
+  control.update_audio_data(in, out, frames, false);
+  CHECK(out[0].channel1 == 0);
+}
+
+/// Custom control which only overrides the documented in place method
+class HalfVolumeControl : public A2DPVolumeControl {
+ public:
+  void update_audio_data(Frame* data, uint16_t frameCount) override {
+    for (int j = 0; j < frameCount; j++) {
+      data[j].channel1 /= 2;
+      data[j].channel2 /= 2;
+    }
+  }
+  void set_volume(uint8_t volume) override {}
+};
+
+void test_supports_fused() {
+  A2DPDefaultVolumeControl vc;
+  A2DPVolumeControl& control = vc;
+  A2DPLinearVolumeControl linear;
+  A2DPNoVolumeControl none;
+  HalfVolumeControl half;
+  CHECK(control.supports_fused());
+  CHECK(((A2DPVolumeControl&)linear).supports_fused());
+  CHECK(((A2DPVolumeControl&)none).supports_fused());
+  // the custom processing must not be skipped
+  CHECK(!half.supports_fused());
+  CHECK(!half.is_unity());
+}
+
+int main() {
+  test_supports_fused();
+  test_unity();
+  test_swap_and_volume();
+  test_mono_downmix();
+  test_fade();
+  return TEST_RESULT();
+}